@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Benchmark for the generator networks of qnn-image-generators
+#
+#-------------------------------------------------
+
+QT       += core concurrent
+
+TARGET = qnn-image-generators-benchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += src/ ../src/ ../../qnn/src
+
+unix: LIBS += -L$$PWD/../ -lqnn-image-generators -L$$PWD/../../qnn/ -lqnn
+win32: LIBS += -L$$PWD/../ -lqnn-image-generators0 -L$$PWD/../../qnn/ -lqnn0
+
+QMAKE_CXXFLAGS += -std=c++11
+
+SOURCES += \
+    src/main.cpp \
+    src/generatorbenchmark.cpp \
+    src/allocationcounter.cpp
+
+HEADERS += \
+    src/generatorbenchmark.h \
+    src/allocationcounter.h
+
+DESTDIR = $$PWD
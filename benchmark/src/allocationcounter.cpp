@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <errno.h>
+#include <stddef.h>
+
+#ifdef __GLIBC__
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+}
+
+namespace
+{
+// Constant initialised, so allocations before the static initialisation are counted as well
+std::atomic<qint64> counter(0);
+}
+
+extern "C" {
+
+void *malloc(size_t size)
+{
+    counter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    counter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    counter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    counter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    counter.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **pointer, size_t alignment, size_t size)
+{
+    counter.fetch_add(1, std::memory_order_relaxed);
+    *pointer = __libc_memalign(alignment, size);
+    return *pointer == NULL && size != 0 ? ENOMEM : 0;
+}
+
+}
+
+bool AllocationCounter::available()
+{
+    return true;
+}
+
+qint64 AllocationCounter::allocations()
+{
+    return counter.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::available()
+{
+    return false;
+}
+
+qint64 AllocationCounter::allocations()
+{
+    return 0;
+}
+
+#endif
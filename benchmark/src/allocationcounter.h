@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+/*!
+ * \brief The AllocationCounter namespace counts the heap allocations of the benchmark process.
+ *
+ * On systems using the GNU C library malloc(), calloc(), realloc() and the aligned allocation functions are replaced by wrappers
+ * which count every call before forwarding it to the C library. As operator new and Qt allocate through these functions,
+ * all allocations of the process (including the allocations of other threads) are counted.
+ * On other systems the counter is not available.
+ */
+
+namespace AllocationCounter
+{
+/*!
+ * \brief Returns if allocations are counted on this system
+ * \return True if the allocation functions are replaced
+ */
+bool available();
+
+/*!
+ * \brief Returns the number of allocations since the start of the process
+ * \return Number of allocations. 0 if the counter is not available
+ */
+qint64 allocations();
+}
+
+#endif // ALLOCATIONCOUNTER_H
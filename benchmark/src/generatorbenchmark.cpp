@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "generatorbenchmark.h"
+#include "allocationcounter.h"
+
+#include <network/lengthchanginggene.h>
+#include <network/cppnprogram.h>
+#include <image/imagewriter.h>
+#include <randomhelper.h>
+
+#include <limits>
+#include <QDir>
+#include <QElapsedTimer>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+GeneratorBenchmark::GeneratorBenchmark(config config) :
+    _config(config),
+    _allocation_free(true)
+{
+    if(Q_UNLIKELY(_config.genomes <= 0))
+    {
+        QNN_FATAL_MSG("At least one genome must be rendered");
+    }
+    if(Q_UNLIKELY(_config.neuron_step <= 0))
+    {
+        QNN_FATAL_MSG("Neuron step must be greater than 0");
+    }
+    if(Q_UNLIKELY(_config.min_neurons < 0 || _config.min_neurons > _config.max_neurons))
+    {
+        QNN_FATAL_MSG("Invalid range of hidden neurons");
+    }
+    if(Q_UNLIKELY(_config.steady_state_evaluations < 0))
+    {
+        QNN_FATAL_MSG("Steady state evaluations must not be negative");
+    }
+    if(_config.steady_state_evaluations > 0 && !AllocationCounter::available())
+    {
+        QNN_WARNING_MSG("Allocations can not be counted on this system");
+    }
+}
+
+bool GeneratorBenchmark::run(QTextStream &stream)
+{
+    _allocation_free = true;
+    stream << "network,width,height,hidden_neurons,activation_mix,disk_output,genomes,seconds_per_genome,pixels_per_second,peak_rss_kb,allocations_per_evaluation" << endl;
+
+    foreach(qint32 size, _config.sizes)
+    {
+        foreach(bool disk_output, _config.disk_output)
+        {
+            if(_config.direct_encoding)
+            {
+                benchmarkDirectEncoding(stream, size, disk_output);
+            }
+            if(_config.cppn)
+            {
+                for(qint32 hidden = _config.min_neurons; hidden <= _config.max_neurons; hidden += _config.neuron_step)
+                {
+                    foreach(activation_mix mix, _config.mixes)
+                    {
+                        benchmarkCPPN(stream, size, hidden, mix, disk_output);
+                    }
+                }
+            }
+        }
+    }
+    return _allocation_free;
+}
+
+GenericGene *GeneratorBenchmark::createCPPNGene(qint32 hidden, activation_mix mix, qint32 max_size)
+{
+    LengthChangingGene::config config;
+    config.min_length = hidden + 3;
+    config.max_length = hidden + 3;
+    GenericGene *gene = new LengthChangingGene(hidden + 3, 1 + ImageCPPNGeneratorNetwork::INPUT_NEURONS*2 + max_size * 2 + 3*2, config);
+
+    for(qint32 neuron = 0; neuron < gene->segments().size(); ++neuron)
+    {
+        qint32 value = 0;
+        bool found = false;
+        // The function is encoded in the first value of the segment. Draw values until one fits the mix
+        while(!found)
+        {
+            value = RandomHelper::getRandomInt(0, std::numeric_limits<qint32>::max());
+            CPPNProgram::activation_function function = CPPNProgram::functionFromGene(value);
+            switch(mix)
+            {
+            case MIX_TRIGONOMETRIC:
+                found = function == CPPNProgram::FUNCTION_COSINUS || function == CPPNProgram::FUNCTION_SINUS;
+                break;
+            case MIX_SIGMOID:
+                found = function == CPPNProgram::FUNCTION_SIGMOID;
+                break;
+            case MIX_GAUSSIAN:
+                found = function == CPPNProgram::FUNCTION_GAUSSIAN;
+                break;
+            case MIX_RANDOM:
+            default:
+                found = function != CPPNProgram::FUNCTION_UNKNOWN;
+                break;
+            }
+        }
+        gene->segments()[neuron][0] = value;
+    }
+    return gene;
+}
+
+QString GeneratorBenchmark::mixName(activation_mix mix)
+{
+    switch(mix)
+    {
+    case MIX_RANDOM:
+        return "random";
+    case MIX_TRIGONOMETRIC:
+        return "trigonometric";
+    case MIX_SIGMOID:
+        return "sigmoid";
+    case MIX_GAUSSIAN:
+        return "gaussian";
+    default:
+        return "<unknown error>";
+    }
+}
+
+GeneratorBenchmark::activation_mix GeneratorBenchmark::mixFromName(QString name, bool *ok)
+{
+    *ok = true;
+    if(name == "random")
+    {
+        return MIX_RANDOM;
+    }
+    else if(name == "trigonometric")
+    {
+        return MIX_TRIGONOMETRIC;
+    }
+    else if(name == "sigmoid")
+    {
+        return MIX_SIGMOID;
+    }
+    else if(name == "gaussian")
+    {
+        return MIX_GAUSSIAN;
+    }
+    *ok = false;
+    return MIX_RANDOM;
+}
+
+qint64 GeneratorBenchmark::peakRSS()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return -1;
+    }
+#ifdef Q_OS_MAC
+    // Bytes on OS X
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+void GeneratorBenchmark::benchmarkCPPN(QTextStream &stream, qint32 size, qint32 hidden, activation_mix mix, bool disk_output)
+{
+    ImageCPPNGeneratorNetwork::config config = _config.cppn_config;
+    config.width = size;
+    config.height = size;
+    config.min_size = qMin(config.min_size, hidden);
+    config.max_size = qMax(config.max_size, hidden);
+    config.save_image = disk_output;
+    config.image_format = _config.image_format;
+    config.image_path = QDir(_config.image_directory).filePath(QString("benchmark-cppn.%1").arg(QString(_config.image_format).toLower()));
+
+    QList<GenericGene *> genes;
+    for(qint32 i = 0; i < _config.genomes; ++i)
+    {
+        genes.append(createCPPNGene(hidden, mix, config.max_size));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    foreach(GenericGene *gene, genes)
+    {
+        ImageCPPNGeneratorNetwork network(0, 0, config);
+        network.initialise(gene);
+        network.processInput(QList<double>());
+    }
+    if(config.asynchronous_save)
+    {
+        ImageWriter::globalInstance()->waitForDone();
+    }
+    qint64 nsecs = timer.nsecsElapsed();
+
+    ImageCPPNGeneratorNetwork network(0, 0, config);
+    network.initialise(createCPPNGene(hidden, mix, config.max_size));
+    double allocations = steadyStateAllocations(network);
+    // QtConcurrent allocates its tasks, supersampling and the caches allocate by design
+    bool expected_free = !disk_output && !config.parallel_rendering && config.supersampling_samples <= 1 && config.activation_cache == NULL && config.render_cache == NULL;
+    checkAllocations("cppn", size, expected_free, allocations);
+    writeResult(stream, "cppn", size, QString::number(hidden), mixName(mix), disk_output, nsecs, allocations);
+}
+
+void GeneratorBenchmark::benchmarkDirectEncoding(QTextStream &stream, qint32 size, bool disk_output)
+{
+    ImageDirectEncodingGeneratorNetwork::config config = _config.direct_encoding_config;
+    config.width = size;
+    config.height = size;
+    config.save_image = disk_output;
+    config.image_format = _config.image_format;
+    config.image_path = QDir(_config.image_directory).filePath(QString("benchmark-direct-encoding.%1").arg(QString(_config.image_format).toLower()));
+
+    ImageDirectEncodingGeneratorNetwork factory(0, 0, config);
+    QList<GenericGene *> genes;
+    for(qint32 i = 0; i < _config.genomes; ++i)
+    {
+        genes.append(factory.getRandomGene());
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    foreach(GenericGene *gene, genes)
+    {
+        ImageDirectEncodingGeneratorNetwork network(0, 0, config);
+        network.initialise(gene);
+        network.processInput(QList<double>());
+    }
+    if(config.asynchronous_save)
+    {
+        ImageWriter::globalInstance()->waitForDone();
+    }
+    qint64 nsecs = timer.nsecsElapsed();
+
+    ImageDirectEncodingGeneratorNetwork network(0, 0, config);
+    network.initialise(factory.getRandomGene());
+    double allocations = steadyStateAllocations(network);
+    checkAllocations("direct_encoding", size, !disk_output, allocations);
+    writeResult(stream, "direct_encoding", size, "na", "na", disk_output, nsecs, allocations);
+}
+
+template<class Network> double GeneratorBenchmark::steadyStateAllocations(Network &network)
+{
+    if(_config.steady_state_evaluations == 0 || !AllocationCounter::available())
+    {
+        return -1.0;
+    }
+
+    QList<double> input;
+    network.processInput(input);
+    ImageWriter::globalInstance()->waitForDone();
+    qint64 allocations = AllocationCounter::allocations();
+    for(qint32 i = 0; i < _config.steady_state_evaluations; ++i)
+    {
+        network.processInput(input);
+        // Images saved on a background thread are released before the next evaluation, so their memory can be reused
+        ImageWriter::globalInstance()->waitForDone();
+    }
+    return (AllocationCounter::allocations() - allocations) / (double) _config.steady_state_evaluations;
+}
+
+void GeneratorBenchmark::checkAllocations(QString network, qint32 size, bool expected_free, double allocations)
+{
+    // -1 means the allocations were not measured
+    if(expected_free && allocations > 0.0)
+    {
+        QNN_WARNING_MSG(QString("%1 network with size %2 allocated %3 times per evaluation, expected 0").arg(network).arg(size).arg(allocations));
+        _allocation_free = false;
+    }
+}
+
+void GeneratorBenchmark::writeResult(QTextStream &stream, QString network, qint32 size, QString hidden, QString mix, bool disk_output, qint64 nsecs, double allocations)
+{
+    double seconds = nsecs / 1e9;
+    double pixels = (double) size * (double) size * _config.genomes;
+    stream << network << ","
+           << size << ","
+           << size << ","
+           << hidden << ","
+           << mix << ","
+           << (disk_output ? 1 : 0) << ","
+           << _config.genomes << ","
+           << QString::number(seconds / _config.genomes, 'g', 6) << ","
+           << QString::number(seconds > 0 ? pixels / seconds : 0.0, 'g', 6) << ","
+           << peakRSS() << ","
+           << QString::number(allocations, 'g', 6) << endl;
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GENERATORBENCHMARK_H
+#define GENERATORBENCHMARK_H
+
+#include <network/imagecppngeneratornetwork.h>
+#include <network/imagedirectencodinggeneratornetwork.h>
+#include <network/genericgene.h>
+
+#include <QList>
+#include <QString>
+#include <QTextStream>
+
+/*!
+ * \brief The GeneratorBenchmark class measures the rendering speed of the generator networks.
+ *
+ * For ImageCPPNGeneratorNetwork it sweeps over image sizes, numbers of hidden neurons, activation function mixes and
+ * rendering with and without saving the image. For ImageDirectEncodingGeneratorNetwork it sweeps over image sizes and saving.
+ *
+ * Every measured configuration is written as one CSV line with the columns
+ * network, width, height, hidden_neurons, activation_mix, disk_output, genomes, seconds_per_genome, pixels_per_second, peak_rss_kb,
+ * allocations_per_evaluation.
+ * Columns which do not apply to a network contain "na". peak_rss_kb is the peak resident set size of the process so far or -1 if unknown.
+ * allocations_per_evaluation is the mean number of heap allocations of repeated evaluations of one network (see steady_state_evaluations)
+ * or -1 if not measured.
+ *
+ * Evaluations which keep the image in memory are expected to be allocation free, unless the CPPN network uses parallel_rendering,
+ * supersampling, activation_cache or render_cache. If such an evaluation allocates, a warning is printed and run() returns false.
+ */
+
+class GeneratorBenchmark
+{
+public:
+    /*!
+     * \brief The activation functions used by the hidden and output neurons of a benchmarked gene
+     */
+    enum activation_mix {
+        MIX_RANDOM,
+        MIX_TRIGONOMETRIC,
+        MIX_SIGMOID,
+        MIX_GAUSSIAN
+    };
+
+    /*!
+     * \brief This struct contains all configuration option of the benchmark
+     */
+    struct config {
+        /*!
+         * \brief Image sizes to benchmark. Images are square
+         */
+        QList<qint32> sizes;
+
+        /*!
+         * \brief Smallest number of hidden neurons
+         */
+        qint32 min_neurons;
+
+        /*!
+         * \brief Biggest number of hidden neurons
+         */
+        qint32 max_neurons;
+
+        /*!
+         * \brief Step between two benchmarked numbers of hidden neurons
+         */
+        qint32 neuron_step;
+
+        /*!
+         * \brief Activation function mixes to benchmark
+         */
+        QList<activation_mix> mixes;
+
+        /*!
+         * \brief Disk output modes to benchmark (false: image is only kept in memory, true: image is saved)
+         */
+        QList<bool> disk_output;
+
+        /*!
+         * \brief Number of genomes rendered per configuration
+         */
+        qint32 genomes;
+
+        /*!
+         * \brief Format used if the image is saved
+         */
+        QByteArray image_format;
+
+        /*!
+         * \brief Directory the images are saved to. Must exist
+         */
+        QString image_directory;
+
+        /*!
+         * \brief If true ImageDirectEncodingGeneratorNetwork is benchmarked
+         */
+        bool direct_encoding;
+
+        /*!
+         * \brief If true ImageCPPNGeneratorNetwork is benchmarked
+         */
+        bool cppn;
+
+        /*!
+         * \brief Template for the configuration of ImageCPPNGeneratorNetwork
+         *
+         * Size, neuron count and saving are overwritten by the benchmark. All other options (e.g. parallel_rendering) are used as set.
+         */
+        ImageCPPNGeneratorNetwork::config cppn_config;
+
+        /*!
+         * \brief Template for the configuration of ImageDirectEncodingGeneratorNetwork
+         *
+         * Size and saving are overwritten by the benchmark.
+         */
+        ImageDirectEncodingGeneratorNetwork::config direct_encoding_config;
+
+        /*!
+         * \brief Number of repeated evaluations of one network used to count the heap allocations. 0 disables the measurement
+         *
+         * The network is evaluated once before counting, so only allocations of the steady state are counted (see AllocationCounter).
+         * The repeated evaluations are not included in the measured time. Configurations expected to be allocation free are checked (see run()).
+         */
+        qint32 steady_state_evaluations;
+
+        /*!
+         * \brief Constructor for standard values
+         */
+        config() :
+            sizes(),
+            min_neurons(0),
+            max_neurons(10),
+            neuron_step(5),
+            mixes(),
+            disk_output(),
+            genomes(3),
+            image_format("PNG"),
+            image_directory("."),
+            direct_encoding(true),
+            cppn(true),
+            cppn_config(),
+            direct_encoding_config(),
+            steady_state_evaluations(0)
+        {
+            sizes << 64 << 256 << 1024 << 4096;
+            mixes << MIX_RANDOM << MIX_TRIGONOMETRIC << MIX_SIGMOID << MIX_GAUSSIAN;
+            disk_output << false << true;
+        }
+    };
+
+    /*!
+     * \brief Constructor
+     * \param config Configuration of the benchmark
+     */
+    GeneratorBenchmark(config config = config());
+
+    /*!
+     * \brief Runs all configured benchmarks
+     * \param stream Stream the CSV lines are written to
+     * \return False if a configuration expected to be allocation free allocated memory in the steady state
+     */
+    bool run(QTextStream &stream);
+
+    /*!
+     * \brief Creates a CPPN gene with a fixed number of hidden neurons
+     * \param hidden Number of hidden neurons
+     * \param mix Activation functions used by the neurons
+     * \param max_size Maximum number of hidden neurons of the network configuration
+     * \return New gene. The caller takes ownership
+     */
+    static GenericGene *createCPPNGene(qint32 hidden, activation_mix mix, qint32 max_size);
+
+    /*!
+     * \brief Returns a human readable name of an activation function mix
+     * \param mix Activation function mix
+     * \return Name of the mix
+     */
+    static QString mixName(activation_mix mix);
+
+    /*!
+     * \brief Parses the name of an activation function mix
+     * \param name Name as returned by mixName()
+     * \param ok Set to false if the name is unknown
+     * \return Activation function mix
+     */
+    static activation_mix mixFromName(QString name, bool *ok);
+
+    /*!
+     * \brief Returns the peak resident set size of the process
+     * \return Peak resident set size in KiB or -1 if unknown
+     */
+    static qint64 peakRSS();
+
+private:
+    config _config;
+
+    /*!
+     * \brief False if a configuration expected to be allocation free allocated memory
+     */
+    bool _allocation_free;
+
+    template<class Network> double steadyStateAllocations(Network &network);
+
+    void benchmarkCPPN(QTextStream &stream, qint32 size, qint32 hidden, activation_mix mix, bool disk_output);
+    void benchmarkDirectEncoding(QTextStream &stream, qint32 size, bool disk_output);
+    void checkAllocations(QString network, qint32 size, bool expected_free, double allocations);
+    void writeResult(QTextStream &stream, QString network, qint32 size, QString hidden, QString mix, bool disk_output, qint64 nsecs, double allocations);
+};
+
+#endif // GENERATORBENCHMARK_H
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "generatorbenchmark.h"
+
+#include <image/imagewriter.h>
+#include <network/cppnkernelcompiler.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QDebug>
+
+namespace {
+QList<qint32> parseIntegerList(QString list, bool *ok)
+{
+    QList<qint32> values;
+    *ok = true;
+    foreach(QString value, list.split(",", QString::SkipEmptyParts))
+    {
+        values.append(value.trimmed().toInt(ok));
+        if(!*ok)
+        {
+            return QList<qint32>();
+        }
+    }
+    return values;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("qnn-image-generators-benchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the rendering speed of the qnn-image-generators networks. The results are written as CSV.");
+    parser.addHelpOption();
+
+    QCommandLineOption sizes_option("sizes", "Comma separated list of image sizes (square images).", "sizes", "64,256,1024,4096");
+    QCommandLineOption min_neurons_option("min-neurons", "Smallest number of hidden neurons.", "count", "0");
+    QCommandLineOption max_neurons_option("max-neurons", "Biggest number of hidden neurons.", "count", "10");
+    QCommandLineOption neuron_step_option("neuron-step", "Step between the numbers of hidden neurons.", "count", "5");
+    QCommandLineOption mixes_option("mixes", "Comma separated list of activation function mixes (random, trigonometric, sigmoid, gaussian).", "mixes", "random,trigonometric,sigmoid,gaussian");
+    QCommandLineOption disk_option("disk-output", "Comma separated list of disk output modes (0: in memory only, 1: save image).", "modes", "0,1");
+    QCommandLineOption genomes_option("genomes", "Number of genomes rendered per configuration.", "count", "3");
+    QCommandLineOption format_option("format", "Image format used for disk output.", "format", "PNG");
+    QCommandLineOption network_option("network", "Networks to benchmark (all, cppn, direct).", "network", "all");
+    QCommandLineOption output_option("output", "Write the results to file instead of stdout.", "file");
+    QCommandLineOption parallel_option("parallel", "Enable parallel_rendering of the CPPN network.");
+    QCommandLineOption batch_option("batch", "Enable batch_evaluation of the CPPN network.");
+    QCommandLineOption separable_option("separable", "Enable separable_evaluation of the CPPN network.");
+    QCommandLineOption float_option("float", "Use PRECISION_FLOAT for the CPPN network.");
+    QCommandLineOption approximate_option("approximate", "Use ACCURACY_APPROXIMATE for the activation functions of the CPPN network.");
+    QCommandLineOption kernel_option("native-kernels", "Compile the CPPN networks into native kernels. The compile time is included in the results.");
+    QCommandLineOption supersampling_option("supersampling", "Maximum number of samples per edge pixel of the CPPN network (1: no supersampling).", "samples", "1");
+    QCommandLineOption supersampling_threshold_option("supersampling-threshold", "Colour difference which marks an edge pixel for supersampling.", "threshold", "16");
+    QCommandLineOption allocations_option("steady-state-allocations", "Count the heap allocations of repeated evaluations of one network (0: disabled). Fails if an evaluation expected to be allocation free allocates.", "evaluations", "0");
+    QCommandLineOption async_option("async-save", "Save the images on a background thread.");
+    QCommandLineOption buffer_gene_option("buffer-gene", "Use RGBBufferGene for the direct encoding network.");
+
+    parser.addOption(sizes_option);
+    parser.addOption(min_neurons_option);
+    parser.addOption(max_neurons_option);
+    parser.addOption(neuron_step_option);
+    parser.addOption(mixes_option);
+    parser.addOption(disk_option);
+    parser.addOption(genomes_option);
+    parser.addOption(format_option);
+    parser.addOption(network_option);
+    parser.addOption(output_option);
+    parser.addOption(parallel_option);
+    parser.addOption(batch_option);
+    parser.addOption(separable_option);
+    parser.addOption(float_option);
+    parser.addOption(approximate_option);
+    parser.addOption(kernel_option);
+    parser.addOption(supersampling_option);
+    parser.addOption(supersampling_threshold_option);
+    parser.addOption(allocations_option);
+    parser.addOption(async_option);
+    parser.addOption(buffer_gene_option);
+    parser.process(a);
+
+    GeneratorBenchmark::config config;
+    bool ok = true;
+    bool all_ok = true;
+
+    config.sizes = parseIntegerList(parser.value(sizes_option), &ok);
+    all_ok &= ok;
+    config.min_neurons = parser.value(min_neurons_option).toInt(&ok);
+    all_ok &= ok;
+    config.max_neurons = parser.value(max_neurons_option).toInt(&ok);
+    all_ok &= ok;
+    config.neuron_step = parser.value(neuron_step_option).toInt(&ok);
+    all_ok &= ok;
+    config.genomes = parser.value(genomes_option).toInt(&ok);
+    all_ok &= ok;
+    config.steady_state_evaluations = parser.value(allocations_option).toInt(&ok);
+    all_ok &= ok && config.steady_state_evaluations >= 0;
+    config.cppn_config.supersampling_samples = parser.value(supersampling_option).toInt(&ok);
+    all_ok &= ok && config.cppn_config.supersampling_samples > 0;
+    config.cppn_config.supersampling_threshold = parser.value(supersampling_threshold_option).toInt(&ok);
+    all_ok &= ok && config.cppn_config.supersampling_threshold >= 0;
+
+    config.mixes.clear();
+    foreach(QString name, parser.value(mixes_option).split(",", QString::SkipEmptyParts))
+    {
+        config.mixes.append(GeneratorBenchmark::mixFromName(name.trimmed(), &ok));
+        all_ok &= ok;
+    }
+
+    config.disk_output.clear();
+    foreach(qint32 mode, parseIntegerList(parser.value(disk_option), &ok))
+    {
+        config.disk_output.append(mode != 0);
+    }
+    all_ok &= ok;
+
+    QString network = parser.value(network_option);
+    config.cppn = network == "all" || network == "cppn";
+    config.direct_encoding = network == "all" || network == "direct";
+    all_ok &= config.cppn || config.direct_encoding;
+
+    if(!all_ok)
+    {
+        qCritical() << "Invalid arguments";
+        parser.showHelp(1);
+    }
+
+    config.image_format = parser.value(format_option).toLatin1();
+    config.cppn_config.parallel_rendering = parser.isSet(parallel_option);
+    config.cppn_config.batch_evaluation = parser.isSet(batch_option);
+    config.cppn_config.separable_evaluation = parser.isSet(separable_option);
+    config.cppn_config.precision = parser.isSet(float_option) ? ImageCPPNGeneratorNetwork::PRECISION_FLOAT : ImageCPPNGeneratorNetwork::PRECISION_DOUBLE;
+    config.cppn_config.accuracy = parser.isSet(approximate_option) ? CPPNProgram::ACCURACY_APPROXIMATE : CPPNProgram::ACCURACY_EXACT;
+    config.cppn_config.asynchronous_save = parser.isSet(async_option);
+    CPPNKernelCompiler kernel_compiler;
+    config.cppn_config.kernel_compiler = parser.isSet(kernel_option) ? &kernel_compiler : NULL;
+    config.direct_encoding_config.asynchronous_save = parser.isSet(async_option);
+    config.direct_encoding_config.buffer_gene = parser.isSet(buffer_gene_option);
+
+    QTemporaryDir directory;
+    if(!directory.isValid())
+    {
+        qCritical() << "Can not create temporary directory";
+        return 1;
+    }
+    config.image_directory = directory.path();
+
+    QFile file;
+    if(parser.isSet(output_option))
+    {
+        file.setFileName(parser.value(output_option));
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        {
+            qCritical() << "Can not open" << file.fileName();
+            return 1;
+        }
+    }
+    else
+    {
+        file.open(stdout, QIODevice::WriteOnly);
+    }
+    QTextStream stream(&file);
+
+    GeneratorBenchmark benchmark(config);
+    bool allocation_free = benchmark.run(stream);
+    ImageWriter::globalInstance()->waitForDone();
+
+    return allocation_free ? 0 : 1;
+}
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core
+QT       += core concurrent
 
 TARGET = qnn-image-generators
 TEMPLATE = lib
@@ -19,13 +19,54 @@ win32: LIBS += -L$$PWD/../qnn/ -lqnn0
 
 QMAKE_CXXFLAGS += -std=c++11
 
+# The library does not use floating point exceptions. Without trapping math the compiler can vectorize the conditional expressions in
+# CPPNApproximations and does not change any result
+QMAKE_CXXFLAGS += -fno-trapping-math
+
+# Record GeneratorStatistics in the networks (qmake CONFIG+=statistics)
+statistics {
+    DEFINES += QNN_IMAGE_GENERATORS_STATISTICS
+}
+
 SOURCES += \ 
     src/network/imagedirectencodinggeneratornetwork.cpp \
-    src/network/imagecppngeneratornetwork.cpp
+    src/network/imagecppngeneratornetwork.cpp \
+    src/network/imagecppnanimationnetwork.cpp \
+    src/network/cppnprogram.cpp \
+    src/network/cppncoordinates.cpp \
+    src/network/rgbbuffergene.cpp \
+    src/network/cppnactivationcache.cpp \
+    src/network/cppnseparablevalues.cpp \
+    src/network/generatorstatistics.cpp \
+    src/network/cppnkernelcompiler.cpp \
+    src/network/cppnrendercontext.cpp \
+    src/network/generatorsnapshot.cpp \
+    src/image/imagewriter.cpp \
+    src/image/ppmstripwriter.cpp \
+    src/image/imagerendercache.cpp \
+    src/image/imagetargetfitness.cpp \
+    src/image/imageupsampler.cpp
 
 HEADERS += \ 
     src/network/imagedirectencodinggeneratornetwork.h \
-    src/network/imagecppngeneratornetwork.h
+    src/network/imagecppngeneratornetwork.h \
+    src/network/imagecppnanimationnetwork.h \
+    src/network/cppnprogram.h \
+    src/network/cppnapproximations.h \
+    src/network/cppncoordinates.h \
+    src/network/rgbbuffergene.h \
+    src/network/cppnactivationcache.h \
+    src/network/cppnseparablevalues.h \
+    src/network/generatorstatistics.h \
+    src/network/cppnkernelcompiler.h \
+    src/network/cppnrendercontext.h \
+    src/network/generatorsnapshot.h \
+    src/image/imagewriter.h \
+    src/image/ppmstripwriter.h \
+    src/image/imagerendercache.h \
+    src/image/lrulist.h \
+    src/image/imagetargetfitness.h \
+    src/image/imageupsampler.h
 
 DESTDIR = $$PWD
 
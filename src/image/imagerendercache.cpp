@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "imagerendercache.h"
+
+#include <QMutexLocker>
+
+ImageRenderCache::ImageRenderCache(qint64 max_bytes) :
+    _max_bytes(max_bytes),
+    _hits(0),
+    _misses(0),
+    _entries(),
+    _mutex()
+{
+    if(Q_UNLIKELY(_max_bytes < 0))
+    {
+        QNN_FATAL_MSG("Maximum bytes must not be negative");
+    }
+}
+
+QImage ImageRenderCache::findImage(quint64 key)
+{
+    QMutexLocker locker(&_mutex);
+    entry *e = _entries.find(key);
+    if(e == NULL || e->image.isNull())
+    {
+        ++_misses;
+        return QImage();
+    }
+    ++_hits;
+    _entries.touch(e);
+    return e->image;
+}
+
+void ImageRenderCache::insertImage(quint64 key, const QImage &image)
+{
+    if((qint64) image.bytesPerLine() * (qint64) image.height() > _max_bytes)
+    {
+        return;
+    }
+
+    QMutexLocker locker(&_mutex);
+    entry *e = _entries.findOrCreate(key);
+    e->image = image;
+    update(e);
+}
+
+bool ImageRenderCache::findFitness(quint64 key, double *fitness)
+{
+    QMutexLocker locker(&_mutex);
+    entry *e = _entries.find(key);
+    if(e == NULL || !e->has_fitness)
+    {
+        ++_misses;
+        return false;
+    }
+    ++_hits;
+    *fitness = e->fitness;
+    _entries.touch(e);
+    return true;
+}
+
+void ImageRenderCache::insertFitness(quint64 key, double fitness)
+{
+    QMutexLocker locker(&_mutex);
+    entry *e = _entries.findOrCreate(key);
+    e->has_fitness = true;
+    e->fitness = fitness;
+    update(e);
+}
+
+void ImageRenderCache::clear()
+{
+    QMutexLocker locker(&_mutex);
+    _entries.clear();
+}
+
+qint64 ImageRenderCache::usedBytes()
+{
+    QMutexLocker locker(&_mutex);
+    return _entries.usedBytes();
+}
+
+qint64 ImageRenderCache::maxBytes() const
+{
+    return _max_bytes;
+}
+
+qint64 ImageRenderCache::hits()
+{
+    QMutexLocker locker(&_mutex);
+    return _hits;
+}
+
+qint64 ImageRenderCache::misses()
+{
+    QMutexLocker locker(&_mutex);
+    return _misses;
+}
+
+qint64 ImageRenderCache::entryBytes(const entry &e)
+{
+    return (qint64) sizeof(entry) + (qint64) e.image.bytesPerLine() * (qint64) e.image.height();
+}
+
+void ImageRenderCache::update(entry *e)
+{
+    _entries.setBytes(e, entryBytes(*e));
+    _entries.evict(_max_bytes);
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IMAGERENDERCACHE_H
+#define IMAGERENDERCACHE_H
+
+#include <qnn-global.h>
+
+#include <image/lrulist.h>
+
+#include <QImage>
+#include <QMutex>
+
+/*!
+ * \brief The ImageRenderCache class stores rendered images and fitness values of genes across evaluations.
+ *
+ * Elitism and crossover often produce genes which were already evaluated. The entries are stored under a key
+ * which identifies the content of the image, e.g. ImageCPPNGeneratorNetwork::renderKey(), so a gene which was already
+ * rendered does not have to be rendered again. In addition the caller can store a fitness value under the same key.
+ *
+ * The memory used by the images is limited by max_bytes. If the limit is reached, the least recently used entries are removed.
+ * The entries are kept in a LRUList, so finding, inserting and removing an entry takes constant time.
+ * Because QImage is implicitly shared, storing and finding images does not copy the pixel data.
+ *
+ * The cache is thread safe and can be shared between multiple networks.
+ */
+
+class QNNSHARED_EXPORT ImageRenderCache
+{
+public:
+    /*!
+     * \brief Constructor
+     * \param max_bytes Maximum memory used by the stored entries in bytes
+     */
+    ImageRenderCache(qint64 max_bytes = 256 * 1024 * 1024);
+
+    /*!
+     * \brief Searches an image
+     * \param key Key of the image
+     * \return The image. Null image if no image is stored under key
+     */
+    QImage findImage(quint64 key);
+
+    /*!
+     * \brief Inserts an image
+     *
+     * A fitness value stored under the same key is kept. If needed, the least recently used entries are removed.
+     * Images bigger than max_bytes are not stored.
+     *
+     * \param key Key of the image
+     * \param image The image
+     */
+    void insertImage(quint64 key, const QImage &image);
+
+    /*!
+     * \brief Searches a fitness value
+     * \param key Key of the fitness value
+     * \param fitness Is set to the fitness value if it is found. Must not be NULL
+     * \return True if a fitness value is stored under key
+     */
+    bool findFitness(quint64 key, double *fitness);
+
+    /*!
+     * \brief Inserts a fitness value
+     *
+     * An image stored under the same key is kept.
+     *
+     * \param key Key of the fitness value
+     * \param fitness The fitness value
+     */
+    void insertFitness(quint64 key, double fitness);
+
+    /*!
+     * \brief Removes all entries
+     */
+    void clear();
+
+    /*!
+     * \brief Returns the memory used by the stored entries
+     * \return Used memory in bytes
+     */
+    qint64 usedBytes();
+
+    /*!
+     * \brief Returns the maximum memory used by the stored entries
+     * \return Maximum memory in bytes
+     */
+    qint64 maxBytes() const;
+
+    /*!
+     * \brief Returns the number of successful calls of findImage() and findFitness()
+     * \return Number of hits
+     */
+    qint64 hits();
+
+    /*!
+     * \brief Returns the number of unsuccessful calls of findImage() and findFitness()
+     * \return Number of misses
+     */
+    qint64 misses();
+
+private:
+    /*!
+     * \brief An entry of the cache (see LRUList)
+     */
+    struct entry {
+        quint64 key;
+        QImage image;
+        bool has_fitness;
+        double fitness;
+        qint64 bytes;
+        entry *previous;
+        entry *next;
+
+        entry(quint64 key) :
+            key(key),
+            image(),
+            has_fitness(false),
+            fitness(0.0),
+            bytes(0),
+            previous(NULL),
+            next(NULL)
+        {
+        }
+    };
+
+    /*!
+     * \brief Returns the memory used by an entry
+     * \param e The entry
+     * \return Used memory in bytes
+     */
+    static qint64 entryBytes(const entry &e);
+
+    /*!
+     * \brief Updates the memory used by an entry and removes the least recently used entries if needed
+     * \param e The changed entry
+     */
+    void update(entry *e);
+
+    qint64 _max_bytes;
+    qint64 _hits;
+    qint64 _misses;
+    LRUList<entry> _entries;
+    QMutex _mutex;
+};
+
+#endif // IMAGERENDERCACHE_H
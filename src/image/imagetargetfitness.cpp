@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "imagetargetfitness.h"
+
+#include <limits>
+#include <cmath>
+#include <string.h>
+
+ImageTargetFitness::ImageTargetFitness(const QImage &target, error_metric metric) :
+    _width(target.width()),
+    _height(target.height()),
+    _metric(metric),
+    _pixels()
+{
+    QImage rgb = target.convertToFormat(QImage::Format_RGB888);
+    _pixels.resize((qint64) _width * _height * 3);
+    for(qint32 row = 0; row < _height; ++row)
+    {
+        // Lines of Format_RGB888 are padded to 4 bytes, the buffer is not
+        memcpy(_pixels.data() + (qint64) row * _width * 3, rgb.constScanLine(row), _width * 3);
+    }
+}
+
+qint32 ImageTargetFitness::width() const
+{
+    return _width;
+}
+
+qint32 ImageTargetFitness::height() const
+{
+    return _height;
+}
+
+ImageTargetFitness::error_metric ImageTargetFitness::metric() const
+{
+    return _metric;
+}
+
+qint64 ImageTargetFitness::error(const QRgb *pixels, qint32 first_row, qint32 rows) const
+{
+    const uchar *target = _pixels.constData() + (qint64) first_row * _width * 3;
+    qint64 count = (qint64) rows * _width;
+    qint64 error = 0;
+    if(_metric == ERROR_SQUARED)
+    {
+        for(qint64 i = 0; i < count; ++i)
+        {
+            qint32 r = qRed(pixels[i]) - target[3 * i];
+            qint32 g = qGreen(pixels[i]) - target[3 * i + 1];
+            qint32 b = qBlue(pixels[i]) - target[3 * i + 2];
+            error += r * r + g * g + b * b;
+        }
+    }
+    else
+    {
+        for(qint64 i = 0; i < count; ++i)
+        {
+            qint32 r = qRed(pixels[i]) - target[3 * i];
+            qint32 g = qGreen(pixels[i]) - target[3 * i + 1];
+            qint32 b = qBlue(pixels[i]) - target[3 * i + 2];
+            error += qAbs(r) + qAbs(g) + qAbs(b);
+        }
+    }
+    return error;
+}
+
+qint64 ImageTargetFitness::errorRGB(const uchar *rgb, qint32 first_row, qint32 rows) const
+{
+    const uchar *target = _pixels.constData() + (qint64) first_row * _width * 3;
+    qint64 count = (qint64) rows * _width * 3;
+    qint64 error = 0;
+    if(_metric == ERROR_SQUARED)
+    {
+        for(qint64 i = 0; i < count; ++i)
+        {
+            qint32 difference = rgb[i] - target[i];
+            error += difference * difference;
+        }
+    }
+    else
+    {
+        for(qint64 i = 0; i < count; ++i)
+        {
+            error += qAbs(rgb[i] - target[i]);
+        }
+    }
+    return error;
+}
+
+double ImageTargetFitness::normalisedError(qint64 error) const
+{
+    double maximum = maximumError();
+    return maximum > 0.0 ? error / maximum : 0.0;
+}
+
+qint64 ImageTargetFitness::errorLimit(double threshold) const
+{
+    if(threshold < 0.0)
+    {
+        return -1;
+    }
+    double limit = threshold * maximumError();
+    // Also true for infinity and NaN
+    if(!(limit < (double) std::numeric_limits<qint64>::max()))
+    {
+        return std::numeric_limits<qint64>::max();
+    }
+    // threshold * maximumError() is rounded, so the limit is corrected until it is consistent with normalisedError()
+    qint64 error_limit = (qint64) std::floor(limit);
+    while(error_limit >= 0 && normalisedError(error_limit) > threshold)
+    {
+        --error_limit;
+    }
+    while(normalisedError(error_limit + 1) <= threshold)
+    {
+        ++error_limit;
+    }
+    return error_limit;
+}
+
+double ImageTargetFitness::maximumError() const
+{
+    double channels = (double) _width * _height * 3;
+    return _metric == ERROR_SQUARED ? channels * 255.0 * 255.0 : channels * 255.0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IMAGETARGETFITNESS_H
+#define IMAGETARGETFITNESS_H
+
+#include <qnn-global.h>
+
+#include <QImage>
+#include <QVector>
+
+/*!
+ * \brief The ImageTargetFitness class compares rendered pixels with a target image.
+ *
+ * The target is converted once into a contiguous RGB buffer, so the generator networks can compare every band of rendered rows
+ * directly after rendering it without creating an image (see ImageCPPNGeneratorNetwork::config::target_fitness).
+ *
+ * The error is accumulated as integer sum over the differences of all channels, so it does not depend on the order in which rows are compared.
+ * normalisedError() converts the sum into the mean error per channel between 0 (identical) and 1.
+ *
+ * All functions are const, so one object can be shared between networks evaluated in parallel.
+ */
+
+class QNNSHARED_EXPORT ImageTargetFitness
+{
+public:
+    /*!
+     * \brief The error calculated for every channel
+     */
+    enum error_metric {
+        /*!
+         * \brief Squared difference. normalisedError() is the mean squared error
+         */
+        ERROR_SQUARED,
+
+        /*!
+         * \brief Absolute difference. normalisedError() is the mean absolute error
+         */
+        ERROR_ABSOLUTE
+    };
+
+    /*!
+     * \brief Constructor
+     * \param target Target image. Is converted to RGB, the alpha channel is ignored
+     * \param metric Error calculated for every channel
+     */
+    ImageTargetFitness(const QImage &target, error_metric metric = ERROR_SQUARED);
+
+    /*!
+     * \brief Returns the width of the target
+     * \return Width in pixel
+     */
+    qint32 width() const;
+
+    /*!
+     * \brief Returns the height of the target
+     * \return Height in pixel
+     */
+    qint32 height() const;
+
+    /*!
+     * \brief Returns the error metric
+     * \return Error metric
+     */
+    error_metric metric() const;
+
+    /*!
+     * \brief Calculates the error of rows in Format_RGB32
+     * \param pixels Pixels of the rows without padding (rows * width() values)
+     * \param first_row Row of the target compared with the first row of pixels
+     * \param rows Number of rows
+     * \return Sum of the errors of all channels
+     */
+    qint64 error(const QRgb *pixels, qint32 first_row, qint32 rows) const;
+
+    /*!
+     * \brief Calculates the error of rows in Format_RGB888
+     * \param rgb Red, green and blue value of every pixel of the rows without padding (rows * width() * 3 values)
+     * \param first_row Row of the target compared with the first row of rgb
+     * \param rows Number of rows
+     * \return Sum of the errors of all channels
+     */
+    qint64 errorRGB(const uchar *rgb, qint32 first_row, qint32 rows) const;
+
+    /*!
+     * \brief Converts an error sum into the mean error per channel of the whole image
+     * \param error Sum of the errors of all channels
+     * \return Mean error between 0 and 1
+     */
+    double normalisedError(qint64 error) const;
+
+    /*!
+     * \brief Returns the biggest error sum whose normalisedError() does not exceed threshold
+     * \param threshold Threshold for the mean error
+     * \return Limit for the error sum. -1 if threshold is negative, std::numeric_limits<qint64>::max() if threshold can not be exceeded
+     */
+    qint64 errorLimit(double threshold) const;
+
+private:
+    /*!
+     * \brief Width of the target
+     */
+    qint32 _width;
+
+    /*!
+     * \brief Height of the target
+     */
+    qint32 _height;
+
+    /*!
+     * \brief Error metric
+     */
+    error_metric _metric;
+
+    /*!
+     * \brief Red, green and blue value of every pixel of the target, row by row without padding
+     */
+    QVector<uchar> _pixels;
+
+    /*!
+     * \brief Returns the error sum of an image which differs by the maximum in every channel
+     * \return Maximum error sum
+     */
+    double maximumError() const;
+};
+
+#endif // IMAGETARGETFITNESS_H
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "imageupsampler.h"
+
+#include <QtCore/qmath.h>
+
+ImageUpsampler::ImageUpsampler(qint32 source_width, qint32 source_height, qint32 width, qint32 height, interpolation_mode mode) :
+    _source_width(source_width),
+    _source_height(source_height),
+    _width(width),
+    _height(height),
+    _mode(mode),
+    _taps(1),
+    _column_index(),
+    _column_weight(),
+    _row_index(),
+    _row_weight()
+{
+    if(Q_UNLIKELY(_source_width <= 0 || _source_height <= 0))
+    {
+        QNN_FATAL_MSG("Source size must be greater than 0");
+    }
+    if(Q_UNLIKELY(_width <= 0 || _height <= 0))
+    {
+        QNN_FATAL_MSG("Size must be greater than 0");
+    }
+
+    switch(_mode)
+    {
+    case INTERPOLATION_NEAREST:
+        _taps = 1;
+        break;
+    case INTERPOLATION_BILINEAR:
+        _taps = 2;
+        break;
+    case INTERPOLATION_BICUBIC:
+        _taps = 4;
+        break;
+    default:
+        QNN_FATAL_MSG("Unknown interpolation mode");
+    }
+
+    calculateTaps(_source_width, _width, _column_index, _column_weight);
+    calculateTaps(_source_height, _height, _row_index, _row_weight);
+
+    // The columns are used as offsets into a RGB row
+    for(qint32 i = 0; i < _column_index.size(); ++i)
+    {
+        _column_index[i] *= 3;
+    }
+}
+
+qint32 ImageUpsampler::sourceWidth() const
+{
+    return _source_width;
+}
+
+qint32 ImageUpsampler::sourceHeight() const
+{
+    return _source_height;
+}
+
+qint32 ImageUpsampler::width() const
+{
+    return _width;
+}
+
+qint32 ImageUpsampler::height() const
+{
+    return _height;
+}
+
+ImageUpsampler::interpolation_mode ImageUpsampler::mode() const
+{
+    return _mode;
+}
+
+void ImageUpsampler::upsample(const uchar *source, qint32 first_row, qint32 rows, uchar *bits, qint32 bytes_per_line, qint32 *intermediate) const
+{
+    const qint32 taps = _taps;
+    const qint32 values = _source_width * 3;
+    const qint32 round = 1 << (2 * WEIGHT_BITS - 1);
+    QVector<qint32> local_intermediate;
+    if(intermediate == NULL)
+    {
+        local_intermediate.resize(values);
+        intermediate = local_intermediate.data();
+    }
+    qint32 *vertical = intermediate;
+    qint32 previous_row = -1;
+
+    for(qint32 row = first_row; row < first_row + rows; ++row)
+    {
+        const qint32 *index = _row_index.constData() + row * taps;
+        const qint32 *weight = _row_weight.constData() + row * taps;
+
+        // Neighbouring rows often use the same source rows and weights, especially with nearest neighbour interpolation
+        bool reuse = previous_row >= 0;
+        for(qint32 tap = 0; tap < taps && reuse; ++tap)
+        {
+            reuse = index[tap] == _row_index[previous_row * taps + tap] && weight[tap] == _row_weight[previous_row * taps + tap];
+        }
+        if(!reuse)
+        {
+            const uchar *source_row = source + (qint64) index[0] * values;
+            for(qint32 i = 0; i < values; ++i)
+            {
+                vertical[i] = weight[0] * source_row[i];
+            }
+            for(qint32 tap = 1; tap < taps; ++tap)
+            {
+                source_row = source + (qint64) index[tap] * values;
+                qint32 w = weight[tap];
+                for(qint32 i = 0; i < values; ++i)
+                {
+                    vertical[i] += w * source_row[i];
+                }
+            }
+        }
+        previous_row = row;
+
+        QRgb *line = reinterpret_cast<QRgb *>(bits + (qint64) (row - first_row) * bytes_per_line);
+        const qint32 *column_index = _column_index.constData();
+        const qint32 *column_weight = _column_weight.constData();
+        for(qint32 column = 0; column < _width; ++column)
+        {
+            qint32 r = round;
+            qint32 g = round;
+            qint32 b = round;
+            for(qint32 tap = 0; tap < taps; ++tap)
+            {
+                const qint32 *value = vertical + column_index[tap];
+                qint32 w = column_weight[tap];
+                r += w * value[0];
+                g += w * value[1];
+                b += w * value[2];
+            }
+            column_index += taps;
+            column_weight += taps;
+            line[column] = qRgb(qBound(0, r >> (2 * WEIGHT_BITS), 255), qBound(0, g >> (2 * WEIGHT_BITS), 255), qBound(0, b >> (2 * WEIGHT_BITS), 255));
+        }
+    }
+}
+
+QImage ImageUpsampler::image(const uchar *source) const
+{
+    QImage image(_width, _height, QImage::Format_RGB32);
+    upsample(source, 0, _height, image.bits(), image.bytesPerLine());
+    return image;
+}
+
+void ImageUpsampler::calculateTaps(qint32 source_size, qint32 size, QVector<qint32> &index, QVector<qint32> &weight) const
+{
+    const qint32 taps = _taps;
+    const double scale = (double) source_size / (double) size;
+    index.resize(size * taps);
+    weight.resize(size * taps);
+
+    for(qint32 i = 0; i < size; ++i)
+    {
+        double position = (i + 0.5) * scale - 0.5;
+        qint32 *tap_index = index.data() + i * taps;
+        qint32 *tap_weight = weight.data() + i * taps;
+
+        if(taps == 1)
+        {
+            tap_index[0] = qBound(0, qFloor((i + 0.5) * scale), source_size - 1);
+            tap_weight[0] = 1 << WEIGHT_BITS;
+            continue;
+        }
+
+        // The first tap lies taps / 2 - 1 pixels before the source pixel left of the position
+        qint32 first = qFloor(position) - (taps / 2 - 1);
+        qint32 sum = 0;
+        qint32 biggest = 0;
+        for(qint32 tap = 0; tap < taps; ++tap)
+        {
+            tap_index[tap] = qBound(0, first + tap, source_size - 1);
+            tap_weight[tap] = qRound(kernel(position - (first + tap)) * (1 << WEIGHT_BITS));
+            sum += tap_weight[tap];
+            if(qAbs(tap_weight[tap]) > qAbs(tap_weight[biggest]))
+            {
+                biggest = tap;
+            }
+        }
+        // Rounding errors are moved to the biggest weight, so a flat source stays exactly flat
+        tap_weight[biggest] += (1 << WEIGHT_BITS) - sum;
+    }
+}
+
+double ImageUpsampler::kernel(double distance) const
+{
+    distance = qAbs(distance);
+    if(_mode == INTERPOLATION_BILINEAR)
+    {
+        return qMax(0.0, 1.0 - distance);
+    }
+
+    // Catmull-Rom spline (Keys kernel with a = -0.5)
+    if(distance < 1.0)
+    {
+        return (1.5 * distance - 2.5) * distance * distance + 1.0;
+    }
+    if(distance < 2.0)
+    {
+        return ((-0.5 * distance + 2.5) * distance - 4.0) * distance + 2.0;
+    }
+    return 0.0;
+}
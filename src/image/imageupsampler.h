@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IMAGEUPSAMPLER_H
+#define IMAGEUPSAMPLER_H
+
+#include <qnn-global.h>
+
+#include <QImage>
+#include <QVector>
+
+/*!
+ * \brief The ImageUpsampler class scales a small RGB buffer up to a bigger image.
+ *
+ * The interpolation is separable: every output row is first interpolated vertically from the source rows into an intermediate row
+ * of source width, which is then interpolated horizontally. The source positions and weights of all rows and columns are calculated
+ * once in the constructor as fixed point values, so upsampling only needs integer multiplications and additions.
+ * If consecutive output rows use the same source rows and weights, the intermediate row is reused.
+ *
+ * Pixel centers are aligned, so output pixel x samples the source at (x + 0.5) * source_width / width - 0.5.
+ * Positions outside of the source are clamped to the border.
+ *
+ * All functions are const, so one object can be shared between threads.
+ */
+
+class QNNSHARED_EXPORT ImageUpsampler
+{
+public:
+    /*!
+     * \brief The interpolation used between the source pixels
+     */
+    enum interpolation_mode {
+        /*!
+         * \brief Nearest neighbour. Every source pixel becomes a block of pixels
+         */
+        INTERPOLATION_NEAREST,
+
+        /*!
+         * \brief Bilinear interpolation between the 2 x 2 nearest source pixels
+         */
+        INTERPOLATION_BILINEAR,
+
+        /*!
+         * \brief Bicubic interpolation (Catmull-Rom) between the 4 x 4 nearest source pixels
+         */
+        INTERPOLATION_BICUBIC
+    };
+
+    /*!
+     * \brief Constructor
+     * \param source_width Width of the source in pixel. Must be greater than 0
+     * \param source_height Height of the source in pixel. Must be greater than 0
+     * \param width Width of the output in pixel. Must be greater than 0
+     * \param height Height of the output in pixel. Must be greater than 0
+     * \param mode Interpolation between the source pixels
+     */
+    ImageUpsampler(qint32 source_width, qint32 source_height, qint32 width, qint32 height, interpolation_mode mode = INTERPOLATION_BILINEAR);
+
+    /*!
+     * \brief Returns the width of the source
+     * \return Width in pixel
+     */
+    qint32 sourceWidth() const;
+
+    /*!
+     * \brief Returns the height of the source
+     * \return Height in pixel
+     */
+    qint32 sourceHeight() const;
+
+    /*!
+     * \brief Returns the width of the output
+     * \return Width in pixel
+     */
+    qint32 width() const;
+
+    /*!
+     * \brief Returns the height of the output
+     * \return Height in pixel
+     */
+    qint32 height() const;
+
+    /*!
+     * \brief Returns the interpolation mode
+     * \return Interpolation mode
+     */
+    interpolation_mode mode() const;
+
+    /*!
+     * \brief Upsamples rows of the output
+     * \param source RGB buffer of the source (three bytes per pixel, no padding between rows) of size sourceWidth() * sourceHeight() * 3
+     * \param first_row First output row
+     * \param rows Number of output rows
+     * \param bits Destination for the rows in the layout of QImage::Format_RGB32. Row first_row is written to bits
+     * \param bytes_per_line Bytes per line of bits
+     * \param intermediate Scratch memory of sourceWidth() * 3 values for the vertically interpolated row. If NULL the memory is allocated for this call
+     */
+    void upsample(const uchar *source, qint32 first_row, qint32 rows, uchar *bits, qint32 bytes_per_line, qint32 *intermediate = NULL) const;
+
+    /*!
+     * \brief Upsamples the complete source into an image
+     * \param source RGB buffer of the source (see upsample())
+     * \return Image of size width() x height() in QImage::Format_RGB32
+     */
+    QImage image(const uchar *source) const;
+
+private:
+    /*!
+     * \brief Number of fraction bits of the weights
+     *
+     * The products of two weights have 20 fraction bits. Even with the negative lobes of bicubic interpolation the sums fit into qint32.
+     */
+    static const qint32 WEIGHT_BITS = 10;
+
+    /*!
+     * \brief Calculates the source positions and weights of one dimension
+     * \param source_size Size of the source
+     * \param size Size of the output
+     * \param index Destination for size * taps source positions
+     * \param weight Destination for size * taps weights
+     */
+    void calculateTaps(qint32 source_size, qint32 size, QVector<qint32> &index, QVector<qint32> &weight) const;
+
+    /*!
+     * \brief Interpolation weight of a source pixel
+     * \param distance Distance between the sample position and the source pixel
+     * \return Weight
+     */
+    double kernel(double distance) const;
+
+    /*!
+     * \brief Width of the source
+     */
+    qint32 _source_width;
+
+    /*!
+     * \brief Height of the source
+     */
+    qint32 _source_height;
+
+    /*!
+     * \brief Width of the output
+     */
+    qint32 _width;
+
+    /*!
+     * \brief Height of the output
+     */
+    qint32 _height;
+
+    /*!
+     * \brief Interpolation mode
+     */
+    interpolation_mode _mode;
+
+    /*!
+     * \brief Number of source pixels per output pixel and dimension (1, 2 or 4)
+     */
+    qint32 _taps;
+
+    /*!
+     * \brief Source column of every tap of every output column
+     */
+    QVector<qint32> _column_index;
+
+    /*!
+     * \brief Weight of every tap of every output column
+     */
+    QVector<qint32> _column_weight;
+
+    /*!
+     * \brief Source row of every tap of every output row
+     */
+    QVector<qint32> _row_index;
+
+    /*!
+     * \brief Weight of every tap of every output row
+     */
+    QVector<qint32> _row_weight;
+};
+
+#endif // IMAGEUPSAMPLER_H
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "imagewriter.h"
+
+#include <QMutexLocker>
+
+ImageWriter::ImageWriter(config config) :
+    _config(config),
+    _queue(),
+    _active_jobs(0),
+    _stop(false),
+    _mutex(),
+    _queue_not_full(),
+    _queue_not_empty(),
+    _done(),
+    _threads()
+{
+    if(Q_UNLIKELY(_config.threads <= 0))
+    {
+        QNN_FATAL_MSG("Number of threads must be greater than 0");
+    }
+    if(Q_UNLIKELY(_config.queue_size <= 0))
+    {
+        QNN_FATAL_MSG("Queue size must be greater than 0");
+    }
+
+    for(qint32 i = 0; i < _config.threads; ++i)
+    {
+        WriterThread *thread = new WriterThread(this);
+        _threads.append(thread);
+        thread->start();
+    }
+}
+
+ImageWriter::~ImageWriter()
+{
+    waitForDone();
+    {
+        QMutexLocker locker(&_mutex);
+        _stop = true;
+        _queue_not_empty.wakeAll();
+    }
+    foreach(WriterThread *thread, _threads)
+    {
+        thread->wait();
+        delete thread;
+    }
+}
+
+void ImageWriter::write(const QImage &image, const QString &path, const QByteArray &format, qint32 quality)
+{
+    job new_job;
+    new_job.image = image;
+    new_job.path = path;
+    new_job.format = format;
+    new_job.quality = quality;
+
+    QMutexLocker locker(&_mutex);
+    while(_queue.size() >= _config.queue_size)
+    {
+        _queue_not_full.wait(&_mutex);
+    }
+    _queue.append(new_job);
+    _queue_not_empty.wakeOne();
+}
+
+void ImageWriter::waitForDone()
+{
+    QMutexLocker locker(&_mutex);
+    while(!_queue.isEmpty() || _active_jobs > 0)
+    {
+        _done.wait(&_mutex);
+    }
+}
+
+ImageWriter *ImageWriter::globalInstance()
+{
+    static ImageWriter writer;
+    return &writer;
+}
+
+bool ImageWriter::writeImage(const QImage &image, const QString &path, const QByteArray &format, qint32 quality)
+{
+    if(!image.save(path, format.isEmpty() ? 0 : format.constData(), quality))
+    {
+        QNN_WARNING_MSG(QString("Could not save image to %1").arg(path));
+        return false;
+    }
+    return true;
+}
+
+void ImageWriter::processQueue()
+{
+    forever
+    {
+        job current_job;
+        {
+            QMutexLocker locker(&_mutex);
+            while(_queue.isEmpty() && !_stop)
+            {
+                _queue_not_empty.wait(&_mutex);
+            }
+            if(_queue.isEmpty())
+            {
+                return;
+            }
+            current_job = _queue.takeFirst();
+            ++_active_jobs;
+            _queue_not_full.wakeOne();
+        }
+
+        writeImage(current_job.image, current_job.path, current_job.format, current_job.quality);
+
+        {
+            QMutexLocker locker(&_mutex);
+            --_active_jobs;
+            if(_queue.isEmpty() && _active_jobs == 0)
+            {
+                _done.wakeAll();
+            }
+        }
+    }
+}
+
+ImageWriter::WriterThread::WriterThread(ImageWriter *writer) :
+    QThread(),
+    _writer(writer)
+{
+}
+
+void ImageWriter::WriterThread::run()
+{
+    _writer->processQueue();
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IMAGEWRITER_H
+#define IMAGEWRITER_H
+
+#include <qnn-global.h>
+
+#include <QImage>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+
+/*!
+ * \brief The ImageWriter class encodes and saves images on background threads.
+ *
+ * Images are put into a bounded queue and written by a fixed number of writer threads.
+ * If the queue is full, write() blocks until a writer thread has taken an image from the queue.
+ * This way the memory used by pending images stays limited while evaluation and encoding overlap.
+ *
+ * Because QImage is implicitly shared, queueing an image does not copy the pixel data.
+ */
+
+class QNNSHARED_EXPORT ImageWriter
+{
+public:
+    /*!
+     * \brief This struct contains all configuration option of the ImageWriter
+     */
+    struct config {
+
+        /*!
+         * \brief Number of writer threads
+         *
+         * Must be greater than zero.
+         */
+        qint32 threads;
+
+        /*!
+         * \brief Maximum number of images waiting in the queue
+         *
+         * Must be greater than zero.
+         */
+        qint32 queue_size;
+
+        /*!
+         * \brief Constructor for standard values
+         */
+        config() :
+            threads(2),
+            queue_size(16)
+        {
+        }
+    };
+
+    /*!
+     * \brief Constructor
+     * \param config Configuration of the ImageWriter
+     */
+    ImageWriter(config config = config());
+
+    /*!
+     * \brief Destructor
+     *
+     * Waits until all queued images are written.
+     */
+    ~ImageWriter();
+
+    /*!
+     * \brief Queues an image for writing
+     *
+     * Blocks while the queue is full.
+     *
+     * \param image Image to write
+     * \param path Path of the file
+     * \param format Format of the file (e.g. "PNG", "PPM", "BMP"). If empty, the format is deduced from the suffix of path
+     * \param quality Quality passed to QImage::save(). For PNG 100 means no compression and 0 means maximum compression, -1 uses the default
+     */
+    void write(const QImage &image, const QString &path, const QByteArray &format = QByteArray(), qint32 quality = -1);
+
+    /*!
+     * \brief Blocks until all queued images are written
+     */
+    void waitForDone();
+
+    /*!
+     * \brief Returns the ImageWriter shared by all networks
+     *
+     * The shared writer uses the standard configuration.
+     * Call waitForDone() before the application exits to make sure all images are written.
+     *
+     * \return Shared writer
+     */
+    static ImageWriter *globalInstance();
+
+    /*!
+     * \brief Writes an image synchronously
+     *
+     * A warning is emitted if the image could not be written.
+     *
+     * \param image Image to write
+     * \param path Path of the file
+     * \param format Format of the file. If empty, the format is deduced from the suffix of path
+     * \param quality Quality passed to QImage::save()
+     * \return True if the image was written
+     */
+    static bool writeImage(const QImage &image, const QString &path, const QByteArray &format = QByteArray(), qint32 quality = -1);
+
+private:
+    /*!
+     * \brief An image waiting to be written
+     */
+    struct job {
+        QImage image;
+        QString path;
+        QByteArray format;
+        qint32 quality;
+    };
+
+    /*!
+     * \brief Thread taking jobs from the queue
+     */
+    class WriterThread : public QThread
+    {
+    public:
+        WriterThread(ImageWriter *writer);
+
+    protected:
+        void run();
+
+    private:
+        ImageWriter *_writer;
+    };
+
+    /*!
+     * \brief Main loop of the writer threads
+     */
+    void processQueue();
+
+    config _config;
+    QList<job> _queue;
+    qint32 _active_jobs;
+    bool _stop;
+    QMutex _mutex;
+    QWaitCondition _queue_not_full;
+    QWaitCondition _queue_not_empty;
+    QWaitCondition _done;
+    QList<WriterThread *> _threads;
+};
+
+#endif // IMAGEWRITER_H
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LRULIST_H
+#define LRULIST_H
+
+#include <qnn-global.h>
+
+#include <QHash>
+#include <QtAlgorithms>
+
+/*!
+ * \brief The LRUList class stores the entries of a cache under their keys in the order of their last use.
+ *
+ * The entries form an intrusive doubly linked list, so finding an entry, marking it as most recently used and removing it takes constant time.
+ * Every entry knows the memory it uses (see setBytes()), evict() removes the least recently used entries until the memory fits into a limit.
+ *
+ * Entry must have the members quint64 key, qint64 bytes, Entry *previous and Entry *next and a constructor Entry(quint64 key)
+ * which sets bytes to 0 and both pointers to NULL. The list owns its entries.
+ *
+ * The list is not thread safe, the caches using it protect it with their own mutex.
+ */
+
+template<class Entry> class LRUList
+{
+public:
+    /*!
+     * \brief Constructor
+     */
+    LRUList();
+
+    /*!
+     * \brief Destructor. Deletes all entries
+     */
+    ~LRUList();
+
+    /*!
+     * \brief Searches an entry without marking it as used
+     * \param key Key of the entry
+     * \return The entry. NULL if no entry is stored under key
+     */
+    Entry *find(quint64 key) const;
+
+    /*!
+     * \brief Returns the entry stored under key and creates it if needed
+     * \param key Key of the entry
+     * \return The entry, marked as most recently used
+     */
+    Entry *findOrCreate(quint64 key);
+
+    /*!
+     * \brief Marks an entry as most recently used
+     * \param e The entry
+     */
+    void touch(Entry *e);
+
+    /*!
+     * \brief Sets the memory used by an entry
+     * \param e The entry
+     * \param bytes Used memory in bytes
+     */
+    void setBytes(Entry *e, qint64 bytes);
+
+    /*!
+     * \brief Removes the least recently used entries until the used memory is not greater than max_bytes
+     * \param max_bytes Maximum memory in bytes
+     */
+    void evict(qint64 max_bytes);
+
+    /*!
+     * \brief Deletes all entries
+     */
+    void clear();
+
+    /*!
+     * \brief Returns the memory used by all entries
+     * \return Used memory in bytes
+     */
+    qint64 usedBytes() const;
+
+private:
+    Q_DISABLE_COPY(LRUList)
+
+    /*!
+     * \brief Removes an entry from the list of used entries
+     * \param e The entry
+     */
+    void unlink(Entry *e);
+
+    QHash<quint64, Entry *> _entries;
+
+    /*!
+     * \brief Most recently used entry
+     */
+    Entry *_first;
+
+    /*!
+     * \brief Least recently used entry
+     */
+    Entry *_last;
+    qint64 _used_bytes;
+};
+
+template<class Entry> LRUList<Entry>::LRUList() :
+    _entries(),
+    _first(NULL),
+    _last(NULL),
+    _used_bytes(0)
+{
+}
+
+template<class Entry> LRUList<Entry>::~LRUList()
+{
+    clear();
+}
+
+template<class Entry> Entry *LRUList<Entry>::find(quint64 key) const
+{
+    return _entries.value(key, NULL);
+}
+
+template<class Entry> Entry *LRUList<Entry>::findOrCreate(quint64 key)
+{
+    Entry *e = _entries.value(key, NULL);
+    if(e == NULL)
+    {
+        e = new Entry(key);
+        _entries.insert(key, e);
+    }
+    touch(e);
+    return e;
+}
+
+template<class Entry> void LRUList<Entry>::touch(Entry *e)
+{
+    if(e == _first)
+    {
+        return;
+    }
+    unlink(e);
+    e->next = _first;
+    if(_first != NULL)
+    {
+        _first->previous = e;
+    }
+    _first = e;
+    if(_last == NULL)
+    {
+        _last = e;
+    }
+}
+
+template<class Entry> void LRUList<Entry>::setBytes(Entry *e, qint64 bytes)
+{
+    _used_bytes += bytes - e->bytes;
+    e->bytes = bytes;
+}
+
+template<class Entry> void LRUList<Entry>::evict(qint64 max_bytes)
+{
+    while(_used_bytes > max_bytes && _last != NULL)
+    {
+        Entry *e = _last;
+        unlink(e);
+        _used_bytes -= e->bytes;
+        _entries.remove(e->key);
+        delete e;
+    }
+}
+
+template<class Entry> void LRUList<Entry>::clear()
+{
+    qDeleteAll(_entries);
+    _entries.clear();
+    _first = NULL;
+    _last = NULL;
+    _used_bytes = 0;
+}
+
+template<class Entry> qint64 LRUList<Entry>::usedBytes() const
+{
+    return _used_bytes;
+}
+
+template<class Entry> void LRUList<Entry>::unlink(Entry *e)
+{
+    if(e->previous != NULL)
+    {
+        e->previous->next = e->next;
+    }
+    else if(_first == e)
+    {
+        _first = e->next;
+    }
+    if(e->next != NULL)
+    {
+        e->next->previous = e->previous;
+    }
+    else if(_last == e)
+    {
+        _last = e->previous;
+    }
+    e->previous = NULL;
+    e->next = NULL;
+}
+
+#endif // LRULIST_H
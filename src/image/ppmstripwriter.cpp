@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ppmstripwriter.h"
+
+PPMStripWriter::PPMStripWriter() :
+    _file(),
+    _width(0),
+    _height(0),
+    _rows(0),
+    _line()
+{
+}
+
+PPMStripWriter::~PPMStripWriter()
+{
+    if(_file.isOpen())
+    {
+        close();
+    }
+}
+
+bool PPMStripWriter::open(const QString &path, qint32 width, qint32 height, bool header)
+{
+    if(Q_UNLIKELY(width <= 0 || height <= 0))
+    {
+        QNN_WARNING_MSG("Width and height must be greater than 0");
+        return false;
+    }
+    if(_file.isOpen())
+    {
+        close();
+    }
+
+    _file.setFileName(path);
+    if(!_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        QNN_WARNING_MSG(QString("Could not open %1").arg(path));
+        return false;
+    }
+    _width = width;
+    _height = height;
+    _rows = 0;
+    _line.resize(width * 3);
+
+    if(!header)
+    {
+        return true;
+    }
+    QByteArray ppm_header = QString("P6\n%1 %2\n255\n").arg(width).arg(height).toLatin1();
+    if(_file.write(ppm_header) != ppm_header.size())
+    {
+        QNN_WARNING_MSG(QString("Could not write to %1").arg(path));
+        _file.close();
+        return false;
+    }
+    return true;
+}
+
+bool PPMStripWriter::writeRows(const QImage &strip, qint32 rows)
+{
+    if(Q_UNLIKELY(strip.width() != _width || rows > strip.height() || (strip.format() != QImage::Format_RGB32 && strip.format() != QImage::Format_RGB888)))
+    {
+        QNN_WARNING_MSG("Strip does not fit the image");
+        return false;
+    }
+
+    if(strip.format() == QImage::Format_RGB888)
+    {
+        for(qint32 row = 0; row < rows; ++row)
+        {
+            if(!writeRGB(strip.constScanLine(row), 1))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uchar *line = reinterpret_cast<uchar *>(_line.data());
+    for(qint32 row = 0; row < rows; ++row)
+    {
+        const QRgb *pixels = reinterpret_cast<const QRgb *>(strip.constScanLine(row));
+        for(qint32 column = 0; column < _width; ++column)
+        {
+            line[3 * column] = qRed(pixels[column]);
+            line[3 * column + 1] = qGreen(pixels[column]);
+            line[3 * column + 2] = qBlue(pixels[column]);
+        }
+        if(!writeRGB(line, 1))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PPMStripWriter::writeRGB(const uchar *data, qint32 rows)
+{
+    if(Q_UNLIKELY(!_file.isOpen() || _rows + rows > _height))
+    {
+        QNN_WARNING_MSG("Too many rows written");
+        return false;
+    }
+    qint64 bytes = (qint64) rows * _width * 3;
+    if(_file.write(reinterpret_cast<const char *>(data), bytes) != bytes)
+    {
+        QNN_WARNING_MSG(QString("Could not write to %1").arg(_file.fileName()));
+        return false;
+    }
+    _rows += rows;
+    return true;
+}
+
+bool PPMStripWriter::close()
+{
+    bool complete = _file.isOpen() && _rows == _height;
+    if(_file.isOpen() && !complete)
+    {
+        QNN_WARNING_MSG(QString("%1 is incomplete: %2 of %3 rows written").arg(_file.fileName()).arg(_rows).arg(_height));
+    }
+    _file.close();
+    return complete;
+}
+
+qint32 PPMStripWriter::rowsWritten() const
+{
+    return _rows;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PPMSTRIPWRITER_H
+#define PPMSTRIPWRITER_H
+
+#include <qnn-global.h>
+
+#include <QImage>
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+
+/*!
+ * \brief The PPMStripWriter class writes a binary PPM (P6) image strip by strip.
+ *
+ * The header is written when the file is opened, afterwards the rows are appended in order.
+ * Only one row is converted at a time, so the memory needed does not depend on the height of the image.
+ * This allows to save images which are too big to be kept in memory as a whole.
+ */
+
+class QNNSHARED_EXPORT PPMStripWriter
+{
+public:
+    /*!
+     * \brief Constructor
+     */
+    PPMStripWriter();
+
+    /*!
+     * \brief Destructor. Closes the file
+     */
+    ~PPMStripWriter();
+
+    /*!
+     * \brief Creates the file and writes the header
+     * \param path Path of the file
+     * \param width Width of the image in pixel
+     * \param height Height of the image in pixel
+     * \param header If false no header is written, so the file only contains raw RGB data (e.g. a raw video stream of height / frame height frames)
+     * \return True on success
+     */
+    bool open(const QString &path, qint32 width, qint32 height, bool header = true);
+
+    /*!
+     * \brief Appends the first rows of an image
+     * \param strip Image with the width of the file (Format_RGB32 or Format_RGB888)
+     * \param rows Number of rows to append
+     * \return True on success
+     */
+    bool writeRows(const QImage &strip, qint32 rows);
+
+    /*!
+     * \brief Appends rows of packed RGB data (3 byte per pixel, no padding)
+     * \param data RGB data
+     * \param rows Number of rows to append
+     * \return True on success
+     */
+    bool writeRGB(const uchar *data, qint32 rows);
+
+    /*!
+     * \brief Closes the file
+     * \return True if all rows of the image were written
+     */
+    bool close();
+
+    /*!
+     * \brief Returns the number of rows written
+     * \return Rows written so far
+     */
+    qint32 rowsWritten() const;
+
+private:
+    QFile _file;
+    qint32 _width;
+    qint32 _height;
+    qint32 _rows;
+    QByteArray _line;
+};
+
+#endif // PPMSTRIPWRITER_H
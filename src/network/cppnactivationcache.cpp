@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cppnactivationcache.h"
+
+#include <network/cppnprogram.h>
+
+#include <QMutexLocker>
+
+CPPNActivationCache::CPPNActivationCache(qint64 max_bytes) :
+    _max_bytes(max_bytes),
+    _hits(0),
+    _misses(0),
+    _entries(),
+    _mutex()
+{
+    if(Q_UNLIKELY(_max_bytes < 0))
+    {
+        QNN_FATAL_MSG("Maximum bytes must not be negative");
+    }
+}
+
+CPPNActivationCache::plane CPPNActivationCache::find(quint64 key)
+{
+    QMutexLocker locker(&_mutex);
+    entry *e = _entries.find(key);
+    if(e == NULL)
+    {
+        ++_misses;
+        return plane();
+    }
+    ++_hits;
+    _entries.touch(e);
+    return e->activations;
+}
+
+void CPPNActivationCache::insert(quint64 key, plane activations)
+{
+    qint64 bytes = (qint64) activations->size() * (qint64) sizeof(double);
+    if(bytes > _max_bytes)
+    {
+        return;
+    }
+
+    QMutexLocker locker(&_mutex);
+    entry *e = _entries.findOrCreate(key);
+    e->activations = activations;
+    _entries.setBytes(e, bytes);
+    _entries.evict(_max_bytes);
+}
+
+void CPPNActivationCache::clear()
+{
+    QMutexLocker locker(&_mutex);
+    _entries.clear();
+}
+
+qint64 CPPNActivationCache::usedBytes()
+{
+    QMutexLocker locker(&_mutex);
+    return _entries.usedBytes();
+}
+
+qint64 CPPNActivationCache::maxBytes() const
+{
+    return _max_bytes;
+}
+
+qint64 CPPNActivationCache::hits()
+{
+    QMutexLocker locker(&_mutex);
+    return _hits;
+}
+
+qint64 CPPNActivationCache::misses()
+{
+    QMutexLocker locker(&_mutex);
+    return _misses;
+}
+
+quint64 CPPNActivationCache::key(quint64 prefix_hash, qint32 width, qint32 height)
+{
+    quint64 key = CPPNProgram::combineHash(prefix_hash, (quint64) (quint32) width);
+    return CPPNProgram::combineHash(key, (quint64) (quint32) height);
+}
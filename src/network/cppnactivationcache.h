@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPNACTIVATIONCACHE_H
+#define CPPNACTIVATIONCACHE_H
+
+#include <qnn-global.h>
+
+#include <image/lrulist.h>
+
+#include <QVector>
+#include <QMutex>
+#include <QSharedPointer>
+
+/*!
+ * \brief The CPPNActivationCache class stores activation planes of CPPN neurons across evaluations.
+ *
+ * An activation plane contains the value of one neuron for every pixel of an image.
+ * Because CPPNs are strictly feed forward, the plane of neuron k only depends on the neurons 0 to k.
+ * The planes are therefore stored under the prefix hash of the neuron (see CPPNProgram::prefixHash()) combined with the image size.
+ * After a mutation only the neurons from the first changed neuron onwards have to be evaluated again.
+ *
+ * The memory used by the planes is limited by max_bytes. If the limit is reached, the least recently used planes are removed.
+ * The planes are kept in a LRUList, so finding, inserting and removing a plane takes constant time.
+ *
+ * The cache is thread safe and can be shared between multiple networks.
+ */
+
+class QNNSHARED_EXPORT CPPNActivationCache
+{
+public:
+    /*!
+     * \brief An activation plane. Contains one value per pixel, row by row
+     */
+    typedef QSharedPointer< const QVector<double> > plane;
+
+    /*!
+     * \brief Constructor
+     * \param max_bytes Maximum memory used by the stored planes in bytes
+     */
+    CPPNActivationCache(qint64 max_bytes = 256 * 1024 * 1024);
+
+    /*!
+     * \brief Searches a plane
+     * \param key Key of the plane (see key())
+     * \return The plane. Null if the plane is not in the cache
+     */
+    plane find(quint64 key);
+
+    /*!
+     * \brief Inserts a plane
+     *
+     * If needed, the least recently used planes are removed.
+     * Planes bigger than max_bytes are not stored.
+     *
+     * \param key Key of the plane (see key())
+     * \param activations The plane
+     */
+    void insert(quint64 key, plane activations);
+
+    /*!
+     * \brief Removes all planes
+     */
+    void clear();
+
+    /*!
+     * \brief Returns the memory used by the stored planes
+     * \return Used memory in bytes
+     */
+    qint64 usedBytes();
+
+    /*!
+     * \brief Returns the maximum memory used by the stored planes
+     * \return Maximum memory in bytes
+     */
+    qint64 maxBytes() const;
+
+    /*!
+     * \brief Returns the number of successful calls of find()
+     * \return Number of hits
+     */
+    qint64 hits();
+
+    /*!
+     * \brief Returns the number of unsuccessful calls of find()
+     * \return Number of misses
+     */
+    qint64 misses();
+
+    /*!
+     * \brief Calculates the key of a plane
+     * \param prefix_hash Prefix hash of the neuron
+     * \param width Width of the image
+     * \param height Height of the image
+     * \return Key of the plane
+     */
+    static quint64 key(quint64 prefix_hash, qint32 width, qint32 height);
+
+private:
+    /*!
+     * \brief An entry of the cache (see LRUList)
+     */
+    struct entry {
+        quint64 key;
+        plane activations;
+        qint64 bytes;
+        entry *previous;
+        entry *next;
+
+        entry(quint64 key) :
+            key(key),
+            activations(),
+            bytes(0),
+            previous(NULL),
+            next(NULL)
+        {
+        }
+    };
+
+    qint64 _max_bytes;
+    qint64 _hits;
+    qint64 _misses;
+    LRUList<entry> _entries;
+    QMutex _mutex;
+};
+
+#endif // CPPNACTIVATIONCACHE_H
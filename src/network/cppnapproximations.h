@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPNAPPROXIMATIONS_H
+#define CPPNAPPROXIMATIONS_H
+
+#include <qnn-global.h>
+
+#include <cmath>
+#include <string.h>
+#include <QtGlobal>
+
+/*!
+ * \brief Fast approximations of the activation functions used by CPPNProgram.
+ *
+ * The functions avoid the calls into libm for every neuron and pixel. The arguments are reduced to a small range
+ * (a multiple of ln(2) for the exponential function, a multiple of pi/2 for the trigonometric functions) and the remainder is
+ * evaluated with a polynomial. The functions are templates on the scalar type so they can be used with float and double.
+ *
+ * Maximum absolute error compared to the std functions, measured in double precision over [-1000, 1000]:
+ * - cosinus(), sinus(): 2e-9
+ * - tanh(): 4e-9
+ * - gaussian(): 5e-9
+ * - sigmoid(): 2e-9
+ *
+ * In float precision the maximum absolute error is 2e-7, which is about two rounding steps of float.
+ */
+
+namespace CPPNApproximations
+{
+    /*!
+     * \brief Maximum absolute value of the arguments of cosinus() and sinus(). Bigger arguments are clamped
+     *
+     * The sum of a neuron is bounded by the number of its connections times the largest input, so this limit is only reached by networks
+     * with millions of neurons.
+     */
+    static const double MAX_TRIGONOMETRIC_ARGUMENT = 1.0e8;
+
+    /*!
+     * \brief Approximation of the exponential function
+     *
+     * Arguments are clamped to [-80, 80].
+     *
+     * \param value Input
+     * \return e^value
+     */
+    template<typename T> inline T exp(T value);
+
+    /*!
+     * \brief Approximation of the cosinus function
+     * \param value Input
+     * \return cosinus of value
+     */
+    template<typename T> inline T cosinus(T value);
+
+    /*!
+     * \brief Approximation of the sinus function
+     * \param value Input
+     * \return sinus of value
+     */
+    template<typename T> inline T sinus(T value);
+
+    /*!
+     * \brief Approximation of the hyperbolic tangent
+     * \param value Input
+     * \return tanh of value
+     */
+    template<typename T> inline T tanh(T value);
+
+    /*!
+     * \brief Approximation of the gaussian function e^(-value^2 / 0.5)
+     * \param value Input
+     * \return gaussian of value
+     */
+    template<typename T> inline T gaussian(T value);
+
+    /*!
+     * \brief Approximation of the sigmoid function 1 / (1 + e^-value)
+     * \param value Input
+     * \return sigmoid of value
+     */
+    template<typename T> inline T sigmoid(T value);
+
+    /*!
+     * \brief Calculates the sinus of quadrant * pi/2 + remainder
+     * \param remainder Remainder of the reduced argument. Must be between -pi/4 and pi/4
+     * \param quadrant Quadrant of the argument
+     * \return sinus of the argument
+     */
+    template<typename T> inline T sinusQuadrant(T remainder, qint32 quadrant);
+
+    /*!
+     * \brief Rounds to the nearest integer, halfway cases to even
+     * \param value Input. Must fit into qint32
+     * \return Rounded value
+     */
+    template<typename T> inline qint32 roundToInt(T value);
+
+    /*!
+     * \brief Returns 1.5 * 2^52, which is used by roundToInt() for double
+     * \return Rounding shift
+     */
+    inline double roundingShift(double);
+
+    /*!
+     * \brief Returns 1.5 * 2^23, which is used by roundToInt() for float
+     * \return Rounding shift
+     */
+    inline float roundingShift(float);
+
+    /*!
+     * \brief Calculates 2^exponent by setting the exponent bits of a double
+     * \param exponent Exponent. Must be between -1022 and 1023
+     * \return 2^exponent
+     */
+    inline double powerOfTwo(double, qint32 exponent);
+
+    /*!
+     * \brief Calculates 2^exponent by setting the exponent bits of a float
+     * \param exponent Exponent. Must be between -126 and 127
+     * \return 2^exponent
+     */
+    inline float powerOfTwo(float, qint32 exponent);
+}
+
+template<typename T> T CPPNApproximations::exp(T value)
+{
+    // Split ln(2) into a part with few significant bits and the rest, so n * ln(2) can be subtracted without losing precision
+    // Written with conditional expressions instead of qBound() so the loops of CPPNProgram::applyFunctionBlock() can be vectorized
+    value = value < (T) -80.0 ? (T) -80.0 : value;
+    value = value > (T) 80.0 ? (T) 80.0 : value;
+    qint32 n = roundToInt(value * (T) 1.44269504088896340736);
+    T r = value - (T) n * (T) 0.693359375 - (T) n * (T) -2.12194440054690582e-4;
+
+    // Taylor polynomial of e^r for |r| <= ln(2)/2
+    T p = (T) (1.0 / 5040.0);
+    p = p * r + (T) (1.0 / 720.0);
+    p = p * r + (T) (1.0 / 120.0);
+    p = p * r + (T) (1.0 / 24.0);
+    p = p * r + (T) (1.0 / 6.0);
+    p = p * r + (T) 0.5;
+    p = p * r + (T) 1.0;
+    p = p * r + (T) 1.0;
+    return p * powerOfTwo((T) 0.0, n);
+}
+
+template<typename T> T CPPNApproximations::cosinus(T value)
+{
+    value = value < (T) -MAX_TRIGONOMETRIC_ARGUMENT ? (T) -MAX_TRIGONOMETRIC_ARGUMENT : value;
+    value = value > (T) MAX_TRIGONOMETRIC_ARGUMENT ? (T) MAX_TRIGONOMETRIC_ARGUMENT : value;
+
+    // cos(x) = sin(x + pi/2)
+    qint32 quadrant = roundToInt(value * (T) 0.636619772367581343076);
+    T r = value - (T) quadrant * (T) 1.5703125 - (T) quadrant * (T) 4.837512969970703125e-4 - (T) quadrant * (T) 7.54978995489188216e-8;
+    return sinusQuadrant(r, quadrant + 1);
+}
+
+template<typename T> T CPPNApproximations::sinus(T value)
+{
+    value = value < (T) -MAX_TRIGONOMETRIC_ARGUMENT ? (T) -MAX_TRIGONOMETRIC_ARGUMENT : value;
+    value = value > (T) MAX_TRIGONOMETRIC_ARGUMENT ? (T) MAX_TRIGONOMETRIC_ARGUMENT : value;
+
+    qint32 quadrant = roundToInt(value * (T) 0.636619772367581343076);
+    T r = value - (T) quadrant * (T) 1.5703125 - (T) quadrant * (T) 4.837512969970703125e-4 - (T) quadrant * (T) 7.54978995489188216e-8;
+    return sinusQuadrant(r, quadrant);
+}
+
+template<typename T> T CPPNApproximations::tanh(T value)
+{
+    return (T) 1.0 - (T) 2.0 / (exp((T) 2.0 * value) + (T) 1.0);
+}
+
+template<typename T> T CPPNApproximations::gaussian(T value)
+{
+    return exp((T) -2.0 * value * value);
+}
+
+template<typename T> T CPPNApproximations::sigmoid(T value)
+{
+    return (T) 1.0 / ((T) 1.0 + exp(-value));
+}
+
+template<typename T> T CPPNApproximations::sinusQuadrant(T remainder, qint32 quadrant)
+{
+    // Both polynomials are evaluated and the result is selected without branches, because the quadrant changes unpredictably between pixels
+    T r2 = remainder * remainder;
+
+    // Taylor polynomial of cos(r)
+    T c = (T) (-1.0 / 3628800.0);
+    c = c * r2 + (T) (1.0 / 40320.0);
+    c = c * r2 + (T) (-1.0 / 720.0);
+    c = c * r2 + (T) (1.0 / 24.0);
+    c = c * r2 + (T) -0.5;
+    c = c * r2 + (T) 1.0;
+
+    // Taylor polynomial of sin(r)
+    T s = (T) (1.0 / 362880.0);
+    s = s * r2 + (T) (-1.0 / 5040.0);
+    s = s * r2 + (T) (1.0 / 120.0);
+    s = s * r2 + (T) (-1.0 / 6.0);
+    s = remainder + remainder * r2 * s;
+
+    T result = (quadrant & 1) ? c : s;
+    return (quadrant & 2) ? -result : result;
+}
+
+template<typename T> qint32 CPPNApproximations::roundToInt(T value)
+{
+    // Adding and subtracting 1.5 * 2^(mantissa bits) rounds to the nearest integer without a branch
+    T shift = roundingShift(value);
+    return (qint32) ((value + shift) - shift);
+}
+
+double CPPNApproximations::roundingShift(double)
+{
+    return 6755399441055744.0;
+}
+
+float CPPNApproximations::roundingShift(float)
+{
+    return 12582912.0f;
+}
+
+double CPPNApproximations::powerOfTwo(double, qint32 exponent)
+{
+    quint64 bits = (quint64) (exponent + 1023) << 52;
+    double result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+float CPPNApproximations::powerOfTwo(float, qint32 exponent)
+{
+    quint32 bits = (quint32) (exponent + 127) << 23;
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+#endif // CPPNAPPROXIMATIONS_H
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cppncoordinates.h"
+
+#include <QtCore/qmath.h>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+CPPNCoordinates::CPPNCoordinates(qint32 width, qint32 height) :
+    _width(width),
+    _height(height),
+    _max_distance(qSqrt(qPow(width, 2) + qPow(height, 2))/2),
+    _x(width),
+    _y(height),
+    _x_offset_squared(width),
+    _y_offset_squared(height),
+    _distance(),
+    _radii(),
+    _radius_index()
+{
+    qint32 x_center = _width / 2;
+    qint32 y_center = _height / 2;
+
+    for(qint32 column = 0; column < _width; ++column)
+    {
+        _x[column] = (qreal) column / (qreal) _width;
+        _x_offset_squared[column] = qPow(column - x_center, 2);
+    }
+    for(qint32 row = 0; row < _height; ++row)
+    {
+        _y[row] = (qreal) row / (qreal) _height;
+        _y_offset_squared[row] = qPow(row - y_center, 2);
+    }
+
+    if((qint64) _width * (qint64) _height <= MAX_PLANE_PIXELS)
+    {
+        _distance.resize(_width * _height);
+        for(qint32 row = 0; row < _height; ++row)
+        {
+            double *distance = _distance.data() + row * _width;
+            for(qint32 column = 0; column < _width; ++column)
+            {
+                distance[column] = qSqrt(_x_offset_squared[column] + _y_offset_squared[row]) / _max_distance;
+            }
+        }
+    }
+
+    // The squared offsets are integers, so the sum of them identifies the distance exactly
+    // The offsets cover all values from 0 to the maximum offset
+    qint64 max_x_offset = qMax(x_center, _width - 1 - x_center);
+    qint64 max_y_offset = qMax(y_center, _height - 1 - y_center);
+    qint64 max_sum = max_x_offset * max_x_offset + max_y_offset * max_y_offset;
+    if(_width > 0 && _height > 0 && max_sum < MAX_PLANE_PIXELS)
+    {
+        _radius_index.fill(-1, max_sum + 1);
+        for(qint64 y_offset = 0; y_offset <= max_y_offset; ++y_offset)
+        {
+            for(qint64 x_offset = 0; x_offset <= max_x_offset; ++x_offset)
+            {
+                _radius_index[x_offset * x_offset + y_offset * y_offset] = 0;
+            }
+        }
+        for(qint32 sum = 0; sum <= max_sum; ++sum)
+        {
+            if(_radius_index[sum] == 0)
+            {
+                _radius_index[sum] = _radii.size();
+                _radii.append(qSqrt((double) sum) / _max_distance);
+            }
+        }
+    }
+}
+
+qint32 CPPNCoordinates::width() const
+{
+    return _width;
+}
+
+qint32 CPPNCoordinates::height() const
+{
+    return _height;
+}
+
+const double *CPPNCoordinates::x() const
+{
+    return _x.constData();
+}
+
+const double *CPPNCoordinates::y() const
+{
+    return _y.constData();
+}
+
+const double *CPPNCoordinates::distanceRow(qint32 row, double *scratch) const
+{
+    if(!_distance.isEmpty())
+    {
+        return _distance.constData() + row * _width;
+    }
+
+    for(qint32 column = 0; column < _width; ++column)
+    {
+        scratch[column] = qSqrt(_x_offset_squared[column] + _y_offset_squared[row]) / _max_distance;
+    }
+    return scratch;
+}
+
+qint32 CPPNCoordinates::radiusCount() const
+{
+    return _radii.size();
+}
+
+const double *CPPNCoordinates::radii() const
+{
+    return _radii.constData();
+}
+
+const qint32 *CPPNCoordinates::radiusIndexRow(qint32 row, qint32 *scratch) const
+{
+    const qint32 *index = _radius_index.constData();
+    for(qint32 column = 0; column < _width; ++column)
+    {
+        scratch[column] = index[(qint32) (_x_offset_squared[column] + _y_offset_squared[row])];
+    }
+    return scratch;
+}
+
+QSharedPointer<const CPPNCoordinates> CPPNCoordinates::get(qint32 width, qint32 height)
+{
+    static QMutex mutex;
+    static QList< QSharedPointer<const CPPNCoordinates> > cache;
+
+    QMutexLocker locker(&mutex);
+    for(qint32 i = 0; i < cache.size(); ++i)
+    {
+        if(cache[i]->width() == width && cache[i]->height() == height)
+        {
+            QSharedPointer<const CPPNCoordinates> coordinates = cache[i];
+            cache.removeAt(i);
+            cache.prepend(coordinates);
+            return coordinates;
+        }
+    }
+
+    QSharedPointer<const CPPNCoordinates> coordinates(new CPPNCoordinates(width, height));
+    cache.prepend(coordinates);
+    while(cache.size() > CACHED_SIZES)
+    {
+        cache.removeLast();
+    }
+    return coordinates;
+}
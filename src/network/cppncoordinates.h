@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPNCOORDINATES_H
+#define CPPNCOORDINATES_H
+
+#include <qnn-global.h>
+
+#include <QVector>
+#include <QSharedPointer>
+
+/*!
+ * \brief The CPPNCoordinates class contains the precalculated coordinate inputs of a CPPN.
+ *
+ * The inputs x, y and distance to center only depend on the width and height of the image.
+ * They are calculated once and can be shared between all networks rendering images of the same size.
+ * Use get() to obtain the shared coordinates for an image size.
+ *
+ * The values are calculated with exactly the same operations as a direct calculation, so rendering with CPPNCoordinates
+ * produces identical images.
+ *
+ * The distance plane is only stored for images up to MAX_PLANE_PIXELS pixels.
+ * For bigger images the distance is calculated row wise from the precalculated squared offsets to the center.
+ *
+ * The distance to center only depends on the sum of the squared offsets, so many pixels share the same distance.
+ * All distinct distances are numbered (see radiusCount()) so values depending only on the distance can be calculated once per distance.
+ */
+
+class QNNSHARED_EXPORT CPPNCoordinates
+{
+public:
+    /*!
+     * \brief Constructor
+     * \param width Width of the image in pixel
+     * \param height Height of the image in pixel
+     */
+    CPPNCoordinates(qint32 width, qint32 height);
+
+    /*!
+     * \brief Returns the width of the image
+     * \return Width in pixel
+     */
+    qint32 width() const;
+
+    /*!
+     * \brief Returns the height of the image
+     * \return Height in pixel
+     */
+    qint32 height() const;
+
+    /*!
+     * \brief Returns the x input of all columns
+     * \return Array of size width()
+     */
+    const double *x() const;
+
+    /*!
+     * \brief Returns the y input of all rows
+     * \return Array of size height()
+     */
+    const double *y() const;
+
+    /*!
+     * \brief Returns the distance to center input of a row
+     * \param row Row of the image
+     * \param scratch Array of size width(). Used if the distance plane is not stored
+     * \return Array of size width(). Either points into the stored distance plane or to scratch
+     */
+    const double *distanceRow(qint32 row, double *scratch) const;
+
+    /*!
+     * \brief Returns the number of distinct distances to the center
+     * \return Number of distinct distances or 0 if the distances are not numbered because the image is to big
+     */
+    qint32 radiusCount() const;
+
+    /*!
+     * \brief Returns all distinct distances to the center
+     * \return Array of size radiusCount()
+     */
+    const double *radii() const;
+
+    /*!
+     * \brief Returns the number of the distance to center of every pixel of a row
+     *
+     * Must only be called if radiusCount() is greater than 0.
+     *
+     * \param row Row of the image
+     * \param scratch Array of size width()
+     * \return Array of size width(). Index into radii()
+     */
+    const qint32 *radiusIndexRow(qint32 row, qint32 *scratch) const;
+
+    /*!
+     * \brief Returns the shared coordinates for an image size
+     *
+     * The most recently used image sizes are cached. This function is thread safe.
+     *
+     * \param width Width of the image in pixel
+     * \param height Height of the image in pixel
+     * \return Shared coordinates
+     */
+    static QSharedPointer<const CPPNCoordinates> get(qint32 width, qint32 height);
+
+    /*!
+     * \brief Maximum number of pixels for which the distance plane is stored
+     */
+    static const qint64 MAX_PLANE_PIXELS = 4 * 1024 * 1024;
+
+    /*!
+     * \brief Number of image sizes kept by get()
+     */
+    static const qint32 CACHED_SIZES = 4;
+
+private:
+    qint32 _width;
+    qint32 _height;
+    double _max_distance;
+    QVector<double> _x;
+    QVector<double> _y;
+    QVector<double> _x_offset_squared;
+    QVector<double> _y_offset_squared;
+    QVector<double> _distance;
+    QVector<double> _radii;
+    QVector<qint32> _radius_index;
+};
+
+#endif // CPPNCOORDINATES_H
@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cppnkernelcompiler.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QProcess>
+#include <QMutexLocker>
+#include <QStandardPaths>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char *CPPNKernelCompiler::KERNEL_SYMBOL = "qnn_cppn_row_kernel";
+
+CPPNKernelCompiler::CPPNKernelCompiler(config config) :
+    _config(config),
+    _kernels(),
+    _libraries(),
+    _compilations(0),
+    _mutex()
+{
+}
+
+QString CPPNKernelCompiler::defaultCacheDirectory()
+{
+    QString location = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if(location.isEmpty())
+    {
+        location = QDir::homePath() + "/.cache";
+    }
+    return location + "/qnn-image-generators-kernels";
+}
+
+CPPNKernelCompiler::~CPPNKernelCompiler()
+{
+    // Deleting a QLibrary does not unload the library
+    foreach(QLibrary *library, _libraries)
+    {
+        delete library;
+    }
+}
+
+CPPNKernelCompiler::row_kernel CPPNKernelCompiler::compile(const CPPNProgram &program, bool single_precision)
+{
+    if(!supported(program))
+    {
+        return NULL;
+    }
+
+    quint64 kernel_key = key(program, single_precision);
+    QMutexLocker locker(&_mutex);
+    if(_kernels.contains(kernel_key))
+    {
+        return _kernels[kernel_key];
+    }
+
+    row_kernel kernel = NULL;
+    QDir directory(_config.cache_directory);
+    if(prepareDirectory())
+    {
+#ifdef Q_OS_WIN
+        QString suffix = "dll";
+#else
+        QString suffix = "so";
+#endif
+        QString library_path = directory.filePath(QString("cppn-kernel-%1.%2").arg(QString::number(kernel_key, 16)).arg(suffix));
+        if(QFile::exists(library_path))
+        {
+            if(trusted(library_path, false))
+            {
+                kernel = load(library_path);
+            }
+            else
+            {
+                QNN_WARNING_MSG("Ignoring kernel not owned by the current user or writable by others:" << library_path);
+                QFile::remove(library_path);
+            }
+        }
+        if(kernel == NULL && build(generateSource(program, single_precision), library_path))
+        {
+            ++_compilations;
+            if(trusted(library_path, false))
+            {
+                kernel = load(library_path);
+            }
+        }
+    }
+
+    // Failed kernels are stored as well so the compiler is not called again for the same program
+    _kernels[kernel_key] = kernel;
+    return kernel;
+}
+
+bool CPPNKernelCompiler::supported(const CPPNProgram &program)
+{
+    if(program.inputCount() != CPPNProgram::TIME_INPUT && program.inputCount() != CPPNProgram::TIME_INPUT + 1)
+    {
+        return false;
+    }
+    foreach(const CPPNProgram::neuron &n, program.neurons())
+    {
+        if(n.stage == CPPNProgram::STAGE_UNUSED)
+        {
+            continue;
+        }
+        switch(n.function)
+        {
+        case CPPNProgram::FUNCTION_COSINUS:
+        case CPPNProgram::FUNCTION_SINUS:
+        case CPPNProgram::FUNCTION_TANH:
+        case CPPNProgram::FUNCTION_IDENTITY:
+        case CPPNProgram::FUNCTION_GAUSSIAN:
+        case CPPNProgram::FUNCTION_SIGMOID:
+        case CPPNProgram::FUNCTION_UNKNOWN:
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+QString CPPNKernelCompiler::generateSource(const CPPNProgram &program, bool single_precision)
+{
+    QString source;
+    source += "// Generated by CPPNKernelCompiler\n";
+    source += "#include <cmath>\n\n";
+    source += QString("typedef %1 T;\n\n").arg(single_precision ? "float" : "double");
+    source += "// Identical to qMin(), qMax() and qBound()\n";
+    source += "static inline T minimum(T a, T b) { return (a < b) ? a : b; }\n";
+    source += "static inline T maximum(T a, T b) { return (a < b) ? b : a; }\n";
+    source += "static inline T bound(T low, T value, T high) { return maximum(low, minimum(high, value)); }\n";
+    source += "static inline unsigned int channel(T value) { return ((unsigned int) (int) std::floor(bound((T) 0.0, value * 255, (T) 255.0))) & 0xffu; }\n\n";
+    // The double version has to be identical to CommonNetworkFunctions::sigmoid(), which is passed to the kernel
+    if(single_precision)
+    {
+        source += "static inline T activation_sigmoid(T value, double (*)(double)) { return 1.0f / (1.0f + std::exp(-value)); }\n\n";
+    }
+    else
+    {
+        source += "static inline T activation_sigmoid(T value, double (*sigmoid)(double)) { return sigmoid(value); }\n\n";
+    }
+
+    source += QString("extern \"C\" void %1(const double *x, double y, const double *distance, int width, double time, unsigned int *line, double (*sigmoid)(double))\n").arg(KERNEL_SYMBOL);
+    source += "{\n";
+    source += "    const T i0 = 1.0;\n";
+    source += "    const T i2 = y;\n";
+    if(program.inputCount() > CPPNProgram::TIME_INPUT)
+    {
+        source += QString("    const T i%1 = time;\n").arg(CPPNProgram::TIME_INPUT);
+    }
+    source += "    T value;\n\n";
+
+    // Constant neurons and neurons only depending on y are calculated once per row
+    for(qint32 neuron = 0; neuron < program.neuronCount(); ++neuron)
+    {
+        CPPNProgram::evaluation_stage stage = program.neurons()[neuron].stage;
+        if(stage == CPPNProgram::STAGE_CONSTANT || stage == CPPNProgram::STAGE_ROW)
+        {
+            generateNeuron(program, neuron, "    ", source);
+        }
+    }
+
+    source += "    for(int column = 0; column < width; ++column)\n";
+    source += "    {\n";
+    source += "        const T i1 = x[column];\n";
+    source += "        const T i3 = distance[column];\n";
+    for(qint32 neuron = 0; neuron < program.neuronCount(); ++neuron)
+    {
+        CPPNProgram::evaluation_stage stage = program.neurons()[neuron].stage;
+        if(stage == CPPNProgram::STAGE_COLUMN || stage == CPPNProgram::STAGE_RADIUS || stage == CPPNProgram::STAGE_PIXEL)
+        {
+            generateNeuron(program, neuron, "        ", source);
+        }
+    }
+    qint32 network_size = program.networkSize();
+    source += QString("        line[column] = 0xff000000u | (channel(%1) << 16) | (channel(%2) << 8) | channel(%3);\n")
+            .arg(variableName(program, network_size - 3))
+            .arg(variableName(program, network_size - 2))
+            .arg(variableName(program, network_size - 1));
+    source += "    }\n";
+    source += "}\n";
+    return source;
+}
+
+qint32 CPPNKernelCompiler::compilations()
+{
+    QMutexLocker locker(&_mutex);
+    return _compilations;
+}
+
+quint64 CPPNKernelCompiler::key(const CPPNProgram &program, bool single_precision) const
+{
+    quint64 hash = program.neuronCount() > 0 ? program.prefixHash(program.neuronCount() - 1) : CPPNProgram::combineHash(0, program.inputCount());
+    hash = CPPNProgram::combineHash(hash, single_precision ? 1 : 0);
+    hash = CPPNProgram::combineHash(hash, SOURCE_VERSION);
+
+    // Different compilers or flags may produce different results
+    QByteArray command = QString("%1 %2").arg(_config.compiler).arg(_config.flags.join(" ")).toUtf8();
+    for(qint32 i = 0; i < command.size(); ++i)
+    {
+        hash = CPPNProgram::combineHash(hash, (uchar) command[i]);
+    }
+    return hash;
+}
+
+bool CPPNKernelCompiler::build(const QString &source, const QString &library_path)
+{
+    // Other processes may compile the same kernel at the same time, so the library is only renamed to library_path when it is complete
+    QString temporary_path = QString("%1.%2").arg(library_path).arg(QCoreApplication::applicationPid());
+    QString source_path = temporary_path + ".cpp";
+
+    QFile file(source_path);
+    if(Q_UNLIKELY(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)))
+    {
+        QNN_WARNING_MSG("Can not write kernel source" << source_path);
+        return false;
+    }
+    QByteArray data = source.toUtf8();
+    bool written = file.write(data.constData(), data.size()) == data.size();
+    file.close();
+    if(Q_UNLIKELY(!written))
+    {
+        QNN_WARNING_MSG("Can not write kernel source" << source_path);
+        QFile::remove(source_path);
+        return false;
+    }
+
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(_config.compiler, QStringList() << _config.flags << "-o" << temporary_path << source_path);
+    bool compiled = process.waitForFinished(-1) && process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+    QFile::remove(source_path);
+    if(Q_UNLIKELY(!compiled))
+    {
+        QNN_WARNING_MSG("Compiling kernel failed:" << process.readAll());
+        QFile::remove(temporary_path);
+        return false;
+    }
+
+    // The library must not be writable by others, independent of the umask of the process
+    QFile::setPermissions(temporary_path, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner | QFileDevice::ReadUser | QFileDevice::WriteUser | QFileDevice::ExeUser);
+    if(!QFile::rename(temporary_path, library_path))
+    {
+        // Another process created the library in the meantime
+        QFile::remove(temporary_path);
+        return QFile::exists(library_path);
+    }
+    return true;
+}
+
+bool CPPNKernelCompiler::prepareDirectory()
+{
+    QDir directory(_config.cache_directory);
+    if(!directory.exists())
+    {
+        if(Q_UNLIKELY(!directory.mkpath(".")))
+        {
+            QNN_WARNING_MSG("Can not create kernel directory" << _config.cache_directory);
+            return false;
+        }
+        QFile::setPermissions(directory.absolutePath(), QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner | QFileDevice::ReadUser | QFileDevice::WriteUser | QFileDevice::ExeUser);
+    }
+    if(Q_UNLIKELY(!trusted(directory.absolutePath(), true)))
+    {
+        QNN_WARNING_MSG("Kernel directory is not owned by the current user or writable by others:" << _config.cache_directory);
+        return false;
+    }
+    return true;
+}
+
+bool CPPNKernelCompiler::trusted(const QString &path, bool directory)
+{
+#ifdef Q_OS_UNIX
+    struct stat status;
+    if(lstat(QFile::encodeName(path).constData(), &status) != 0)
+    {
+        return false;
+    }
+    if(directory ? !S_ISDIR(status.st_mode) : !S_ISREG(status.st_mode))
+    {
+        return false;
+    }
+    return status.st_uid == geteuid() && (status.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+#else
+    Q_UNUSED(path);
+    Q_UNUSED(directory);
+    return true;
+#endif
+}
+
+CPPNKernelCompiler::row_kernel CPPNKernelCompiler::load(const QString &library_path)
+{
+    QLibrary *library = new QLibrary(library_path);
+    if(Q_UNLIKELY(!library->load()))
+    {
+        QNN_WARNING_MSG("Can not load kernel:" << library->errorString());
+        delete library;
+        return NULL;
+    }
+    row_kernel kernel = reinterpret_cast<row_kernel>(library->resolve(KERNEL_SYMBOL));
+    if(Q_UNLIKELY(kernel == NULL))
+    {
+        QNN_WARNING_MSG("Kernel not found in" << library_path);
+        library->unload();
+        delete library;
+        return NULL;
+    }
+    _libraries.append(library);
+    return kernel;
+}
+
+QString CPPNKernelCompiler::variableName(const CPPNProgram &program, qint32 input)
+{
+    if(input < program.inputCount())
+    {
+        return QString("i%1").arg(input);
+    }
+    return QString("n%1").arg(input - program.inputCount());
+}
+
+void CPPNKernelCompiler::generateNeuron(const CPPNProgram &program, qint32 neuron, const QString &indentation, QString &source)
+{
+    // The weighted sum is calculated in the same order as CPPNProgram::evaluate(), starting from 0
+    const CPPNProgram::neuron &n = program.neurons()[neuron];
+    source += indentation + "value = 0.0;\n";
+    for(qint32 c = n.first_connection; c < n.first_connection + n.connection_count; ++c)
+    {
+        const CPPNProgram::connection &connection = program.connections()[c];
+        // 17 significant digits restore the exact double value of the weight
+        source += QString("%1value += %2 * (T) %3;\n").arg(indentation).arg(variableName(program, connection.input)).arg(QString::number(connection.weight, 'g', 17));
+    }
+
+    QString function;
+    switch(n.function)
+    {
+    case CPPNProgram::FUNCTION_COSINUS:
+        function = "std::cos(value)";
+        break;
+    case CPPNProgram::FUNCTION_SINUS:
+        function = "std::sin(value)";
+        break;
+    case CPPNProgram::FUNCTION_TANH:
+        function = "std::tanh(value)";
+        break;
+    case CPPNProgram::FUNCTION_IDENTITY:
+        function = "bound((T) 0.0, value, (T) 1.0)";
+        break;
+    case CPPNProgram::FUNCTION_GAUSSIAN:
+        function = "std::exp((T) -2.0 * value * value)";
+        break;
+    case CPPNProgram::FUNCTION_SIGMOID:
+        function = "activation_sigmoid(value, sigmoid)";
+        break;
+    case CPPNProgram::FUNCTION_UNKNOWN:
+    default:
+        function = "value";
+        break;
+    }
+    source += QString("%1const T %2 = %3;\n").arg(indentation).arg(variableName(program, program.inputCount() + neuron)).arg(function);
+}
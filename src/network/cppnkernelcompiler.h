@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPNKERNELCOMPILER_H
+#define CPPNKERNELCOMPILER_H
+
+#include <qnn-global.h>
+
+#include <network/cppnprogram.h>
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QLibrary>
+#include <QDir>
+#include <QRgb>
+
+/*!
+ * \brief The CPPNKernelCompiler class translates a CPPNProgram into native code.
+ *
+ * Even the decoded CPPNProgram loops over the neurons and connections of the network and dispatches on the activation function for every pixel.
+ * The kernel compiler writes the network as straight-line C++ code: Every needed neuron becomes one weighted sum with the weights as constants,
+ * connections and neurons which can not influence the output are left out and constant neurons and neurons only depending on y are calculated once per row.
+ * The source is compiled with the system compiler into a shared library, which is loaded with QLibrary.
+ *
+ * Compiling takes a few hundred milliseconds, so kernels only pay off for big images or animations, e.g. when rendering the champion of an evolution.
+ * The compiled libraries are stored in cache_directory under the hash of the program (see CPPNProgram::prefixHash()) and loaded kernels are kept in memory,
+ * so every network is only compiled once, even across processes.
+ *
+ * The kernel calculates exactly the same values as CPPNProgram::evaluate() as long as the compiler does not contract multiplications and additions
+ * (see config::flags). Programs using the approximate activation functions (see CPPNProgram::ACCURACY_APPROXIMATE) are not compiled.
+ *
+ * The compiler is thread safe and can be shared between multiple networks. Loaded libraries stay loaded until the process exits.
+ */
+
+class QNNSHARED_EXPORT CPPNKernelCompiler
+{
+public:
+    /*!
+     * \brief A compiled kernel. Renders one row of an image
+     *
+     * \param x The x coordinate of every column (see CPPNCoordinates::x())
+     * \param y The y coordinate of the row
+     * \param distance The distance to the center of every column (see CPPNCoordinates::distanceRow())
+     * \param width Number of pixels in the row
+     * \param time Value of the time input (see CPPNProgram::TIME_INPUT). Ignored if the program has no time input
+     * \param line First pixel of the row (Format_RGB32)
+     * \param sigmoid Must be CommonNetworkFunctions::sigmoid()
+     */
+    typedef void (*row_kernel)(const double *x, double y, const double *distance, qint32 width, double time, QRgb *line, double (*sigmoid)(double));
+
+    /*!
+     * \brief This struct contains all configuration option of the CPPNKernelCompiler
+     */
+    struct config {
+        /*!
+         * \brief The C++ compiler. Is called with flags, the output file and the source file
+         */
+        QString compiler;
+
+        /*!
+         * \brief The flags passed to the compiler
+         *
+         * The flags have to produce a shared library. -ffp-contract=off is needed for results identical to CPPNProgram::evaluate() on
+         * processors supporting fused multiply-add.
+         */
+        QStringList flags;
+
+        /*!
+         * \brief The directory the sources and compiled libraries are stored in. Is created if needed
+         *
+         * The libraries in the directory are loaded into the process, so the directory must be private to the current user.
+         * The default is a directory in the cache location of the user (see QStandardPaths::GenericCacheLocation). A new directory is created
+         * with access for the owner only. On Unix the directory and every library must be owned by the current user, must not be symbolic links and must not be writable
+         * by group or others. Otherwise no kernel is loaded from the directory, libraries failing the check are compiled again.
+         */
+        QString cache_directory;
+
+        /*!
+         * \brief Constructor for standard values
+         */
+        config() :
+            compiler("c++"),
+            flags(QStringList() << "-O2" << "-fno-trapping-math" << "-ffp-contract=off" << "-shared" << "-fPIC" << "-w"),
+            cache_directory(defaultCacheDirectory())
+        {
+        }
+    };
+
+    /*!
+     * \brief Constructor
+     * \param config Configuration of the CPPNKernelCompiler
+     */
+    CPPNKernelCompiler(config config = config());
+
+    /*!
+     * \brief Returns the default of config::cache_directory
+     * \return Directory in the cache location of the current user
+     */
+    static QString defaultCacheDirectory();
+
+    /*!
+     * \brief Destructor
+     *
+     * The loaded libraries are not unloaded, kernels returned by compile() stay valid.
+     */
+    ~CPPNKernelCompiler();
+
+    /*!
+     * \brief Returns the kernel of a program, compiling it if needed
+     *
+     * Compiling is serialised, concurrent calls wait until the running compilation is finished.
+     *
+     * \param program Decoded network
+     * \param single_precision If true the network is evaluated with float (see ImageCPPNGeneratorNetwork::PRECISION_FLOAT), otherwise with double
+     * \return The kernel. NULL if the program is not supported or compiling failed
+     */
+    row_kernel compile(const CPPNProgram &program, bool single_precision);
+
+    /*!
+     * \brief Returns whether a program can be compiled
+     * \param program Decoded network
+     * \return False if a needed neuron uses an approximate activation function
+     */
+    static bool supported(const CPPNProgram &program);
+
+    /*!
+     * \brief Generates the C++ source of the kernel of a program
+     *
+     * The source defines the function KERNEL_SYMBOL with the signature of row_kernel.
+     *
+     * \param program Decoded network. Must be supported()
+     * \param single_precision If true the network is evaluated with float, otherwise with double
+     * \return C++ source
+     */
+    static QString generateSource(const CPPNProgram &program, bool single_precision);
+
+    /*!
+     * \brief Returns the number of kernels compiled by the system compiler
+     * \return Number of compilations. Kernels loaded from cache_directory or memory are not counted
+     */
+    qint32 compilations();
+
+    /*!
+     * \brief Name of the kernel function in the generated source
+     */
+    static const char *KERNEL_SYMBOL;
+
+    /*!
+     * \brief Version of the generated source. Part of the file names so outdated libraries in cache_directory are not used
+     */
+    static const qint32 SOURCE_VERSION = 1;
+
+private:
+    /*!
+     * \brief Configuration of the compiler
+     */
+    config _config;
+
+    /*!
+     * \brief Loaded kernels by key. NULL if the kernel could not be created
+     */
+    QHash<quint64, row_kernel> _kernels;
+
+    /*!
+     * \brief Loaded libraries
+     */
+    QList<QLibrary *> _libraries;
+
+    /*!
+     * \brief Number of compilations
+     */
+    qint32 _compilations;
+
+    /*!
+     * \brief Mutex protecting all members
+     */
+    QMutex _mutex;
+
+    /*!
+     * \brief Calculates the key of a kernel
+     * \param program Decoded network
+     * \param single_precision Scalar type of the kernel
+     * \return Key
+     */
+    quint64 key(const CPPNProgram &program, bool single_precision) const;
+
+    /*!
+     * \brief Compiles source into the shared library library_path
+     * \param source C++ source
+     * \param library_path Path of the library
+     * \return True if the library was created
+     */
+    bool build(const QString &source, const QString &library_path);
+
+    /*!
+     * \brief Creates cache_directory if needed and checks that it is private to the current user
+     * \return True if libraries may be stored in and loaded from the directory
+     */
+    bool prepareDirectory();
+
+    /*!
+     * \brief Checks that a file or directory is owned by the current user and not writable by group or others
+     *
+     * Always true on systems other than Unix.
+     *
+     * \param path Path of the file or directory. Symbolic links are not followed
+     * \param directory True if path must be a directory, false if it must be a regular file
+     * \return True if the path is trusted
+     */
+    static bool trusted(const QString &path, bool directory);
+
+    /*!
+     * \brief Loads a kernel from a shared library
+     * \param library_path Path of the library
+     * \return The kernel. NULL if the library can not be loaded
+     */
+    row_kernel load(const QString &library_path);
+
+    /*!
+     * \brief Returns the name of the variable holding an input or neuron in the generated source
+     * \param program Decoded network
+     * \param input Index in the network (inputs first, then neurons)
+     * \return Name of the variable
+     */
+    static QString variableName(const CPPNProgram &program, qint32 input);
+
+    /*!
+     * \brief Appends the calculation of a neuron to the generated source
+     * \param program Decoded network
+     * \param neuron Number of the neuron
+     * \param indentation Indentation of the lines
+     * \param source Source to append to
+     */
+    static void generateNeuron(const CPPNProgram &program, qint32 neuron, const QString &indentation, QString &source);
+};
+
+#endif // CPPNKERNELCOMPILER_H
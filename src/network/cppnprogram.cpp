@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cppnprogram.h"
+
+#include <string.h>
+
+using CommonNetworkFunctions::weight;
+using CommonNetworkFunctions::floatFromGeneInput;
+
+CPPNProgram::CPPNProgram() :
+    _inputs(0),
+    _neurons(),
+    _connections(),
+    _prefix_hashes(),
+    _stages()
+{
+}
+
+void CPPNProgram::decode(QList< QList<qint32> > &segments, qint32 inputs, activation_accuracy accuracy)
+{
+    _inputs = inputs;
+    _neurons.clear();
+    _connections.clear();
+    _prefix_hashes.clear();
+    _neurons.reserve(segments.size());
+    _prefix_hashes.reserve(segments.size());
+    quint64 hash = combineHash(0, inputs);
+
+    for(qint32 i = 0; i < segments.size(); ++i)
+    {
+        const QList<qint32> &segment = segments[i];
+        neuron n;
+        n.function = functionFromGene(segment[0]);
+        n.first_connection = _connections.size();
+        n.connection_count = 0;
+        n.dependencies = DEPENDENCY_NONE;
+        n.stage = STAGE_PIXEL;
+
+        if(Q_UNLIKELY(n.function == FUNCTION_UNKNOWN))
+        {
+            QNN_CRITICAL_MSG("Unknown function" << qFloor(floatFromGeneInput(segment[0], 5)));
+        }
+        if(accuracy == ACCURACY_APPROXIMATE)
+        {
+            n.function = approximateFunction(n.function);
+        }
+
+        hash = combineHash(hash, n.function);
+        for(qint32 input = 0; input < i + inputs; ++input)
+        {
+            if(weight(segment[1 + (2 * input)], 1) > 0)
+            {
+                connection c;
+                c.input = input;
+                c.weight = weight(segment[1 + (2 * input) + 1], 1);
+                _connections.append(c);
+                ++n.connection_count;
+
+                quint64 weight_bits;
+                memcpy(&weight_bits, &c.weight, sizeof(weight_bits));
+                hash = combineHash(hash, c.input);
+                hash = combineHash(hash, weight_bits);
+            }
+        }
+        hash = combineHash(hash, n.connection_count);
+        _neurons.append(n);
+        _prefix_hashes.append(hash);
+    }
+
+    analyse();
+}
+
+bool CPPNProgram::load(qint32 inputs, const qint32 *functions, const qint32 *connection_counts, qint32 neurons, const qint32 *connection_inputs, const double *connection_weights, qint32 connections)
+{
+    _inputs = inputs;
+    _neurons.clear();
+    _connections.clear();
+    _prefix_hashes.clear();
+    _neurons.reserve(neurons);
+    _connections.reserve(connections);
+    _prefix_hashes.reserve(neurons);
+    quint64 hash = combineHash(0, inputs);
+    bool valid = true;
+
+    for(qint32 i = 0; i < neurons && valid; ++i)
+    {
+        neuron n;
+        n.function = (activation_function) functions[i];
+        n.first_connection = _connections.size();
+        n.connection_count = connection_counts[i];
+        n.dependencies = DEPENDENCY_NONE;
+        n.stage = STAGE_PIXEL;
+
+        if(Q_UNLIKELY(functions[i] < 0 || functions[i] >= FUNCTION_UNKNOWN || n.connection_count < 0 || n.connection_count > connections - n.first_connection))
+        {
+            QNN_WARNING_MSG(QString("Neuron %1 is invalid").arg(i));
+            valid = false;
+            break;
+        }
+
+        hash = combineHash(hash, n.function);
+        for(qint32 c = n.first_connection; c < n.first_connection + n.connection_count; ++c)
+        {
+            if(Q_UNLIKELY(connection_inputs[c] < 0 || connection_inputs[c] >= i + inputs))
+            {
+                QNN_WARNING_MSG(QString("Connection %1 of neuron %2 is invalid").arg(c).arg(i));
+                valid = false;
+                break;
+            }
+            connection con;
+            con.input = connection_inputs[c];
+            con.weight = connection_weights[c];
+            _connections.append(con);
+
+            quint64 weight_bits;
+            memcpy(&weight_bits, &con.weight, sizeof(weight_bits));
+            hash = combineHash(hash, con.input);
+            hash = combineHash(hash, weight_bits);
+        }
+        hash = combineHash(hash, n.connection_count);
+        _neurons.append(n);
+        _prefix_hashes.append(hash);
+    }
+
+    if(valid && Q_UNLIKELY(_connections.size() != connections))
+    {
+        QNN_WARNING_MSG("Number of connections does not fit");
+        valid = false;
+    }
+    if(!valid)
+    {
+        _inputs = 0;
+        _neurons.clear();
+        _connections.clear();
+        _prefix_hashes.clear();
+    }
+
+    analyse();
+    return valid;
+}
+
+qint32 CPPNProgram::inputCount() const
+{
+    return _inputs;
+}
+
+qint32 CPPNProgram::neuronCount() const
+{
+    return _neurons.size();
+}
+
+qint32 CPPNProgram::networkSize() const
+{
+    return _inputs + _neurons.size();
+}
+
+const QVector<CPPNProgram::neuron> &CPPNProgram::neurons() const
+{
+    return _neurons;
+}
+
+const QVector<CPPNProgram::connection> &CPPNProgram::connections() const
+{
+    return _connections;
+}
+
+const QVector<qint32> &CPPNProgram::stageNeurons(evaluation_stage stage) const
+{
+    return _stages[stage];
+}
+
+quint64 CPPNProgram::prefixHash(qint32 i) const
+{
+    return _prefix_hashes[i];
+}
+
+quint64 CPPNProgram::combineHash(quint64 hash, quint64 value)
+{
+    hash ^= value + Q_UINT64_C(0x9e3779b97f4a7c15) + (hash << 6) + (hash >> 2);
+    hash *= Q_UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    return hash;
+}
+
+void CPPNProgram::analyse()
+{
+    // Dependencies of the inputs: bias, x, y, distance to center, time. Additional inputs are treated as depending on everything
+    QVector<qint32> dependencies(_inputs + _neurons.size(), DEPENDENCY_X | DEPENDENCY_Y | DEPENDENCY_DISTANCE);
+    static const qint32 input_dependencies[] = {DEPENDENCY_NONE, DEPENDENCY_X, DEPENDENCY_Y, DEPENDENCY_DISTANCE, DEPENDENCY_NONE};
+    for(qint32 input = 0; input < qMin(_inputs, TIME_INPUT + 1); ++input)
+    {
+        dependencies[input] = input_dependencies[input];
+    }
+
+    for(qint32 i = 0; i < _neurons.size(); ++i)
+    {
+        neuron &n = _neurons[i];
+        n.dependencies = DEPENDENCY_NONE;
+        for(qint32 c = n.first_connection; c < n.first_connection + n.connection_count; ++c)
+        {
+            n.dependencies |= dependencies[_connections[c].input];
+        }
+        dependencies[_inputs + i] = n.dependencies;
+    }
+
+    // Walk backwards from the outputs to find all neurons which influence the image
+    QVector<bool> needed(_neurons.size(), false);
+    for(qint32 i = qMax(0, _neurons.size() - 3); i < _neurons.size(); ++i)
+    {
+        needed[i] = true;
+    }
+    for(qint32 i = _neurons.size() - 1; i >= 0; --i)
+    {
+        if(!needed[i])
+        {
+            continue;
+        }
+        const neuron &n = _neurons[i];
+        for(qint32 c = n.first_connection; c < n.first_connection + n.connection_count; ++c)
+        {
+            if(_connections[c].input >= _inputs)
+            {
+                needed[_connections[c].input - _inputs] = true;
+            }
+        }
+    }
+
+    for(qint32 stage = 0; stage < STAGE_COUNT; ++stage)
+    {
+        _stages[stage].clear();
+    }
+    for(qint32 i = 0; i < _neurons.size(); ++i)
+    {
+        neuron &n = _neurons[i];
+        if(!needed[i])
+        {
+            n.stage = STAGE_UNUSED;
+        }
+        else
+        {
+            switch(n.dependencies)
+            {
+            case DEPENDENCY_NONE:
+                n.stage = STAGE_CONSTANT;
+                break;
+            case DEPENDENCY_X:
+                n.stage = STAGE_COLUMN;
+                break;
+            case DEPENDENCY_Y:
+                n.stage = STAGE_ROW;
+                break;
+            case DEPENDENCY_DISTANCE:
+                n.stage = STAGE_RADIUS;
+                break;
+            default:
+                n.stage = STAGE_PIXEL;
+                break;
+            }
+        }
+        _stages[n.stage].append(i);
+    }
+}
+
+CPPNProgram::activation_function CPPNProgram::functionFromGene(qint32 geneValue)
+{
+    switch(qFloor(floatFromGeneInput(geneValue, 6)))
+    {
+    case 0:
+        return FUNCTION_COSINUS;
+    case 1:
+        return FUNCTION_SINUS;
+    case 2:
+        return FUNCTION_TANH;
+    case 3:
+        return FUNCTION_IDENTITY;
+    case 4:
+        return FUNCTION_GAUSSIAN;
+    case 5:
+    case 6: // 6 is an extreme corner case which should almost never occure
+        return FUNCTION_SIGMOID;
+    default:
+        return FUNCTION_UNKNOWN;
+    }
+}
+
+CPPNProgram::activation_function CPPNProgram::approximateFunction(activation_function function)
+{
+    switch(function)
+    {
+    case FUNCTION_COSINUS:
+        return FUNCTION_COSINUS_APPROXIMATE;
+    case FUNCTION_SINUS:
+        return FUNCTION_SINUS_APPROXIMATE;
+    case FUNCTION_TANH:
+        return FUNCTION_TANH_APPROXIMATE;
+    case FUNCTION_GAUSSIAN:
+        return FUNCTION_GAUSSIAN_APPROXIMATE;
+    case FUNCTION_SIGMOID:
+        return FUNCTION_SIGMOID_APPROXIMATE;
+    default:
+        return function;
+    }
+}
+
+QString CPPNProgram::functionName(activation_function function)
+{
+    switch(function)
+    {
+    case FUNCTION_COSINUS:
+        return "cosinus";
+    case FUNCTION_SINUS:
+        return "sinus";
+    case FUNCTION_TANH:
+        return "tanh";
+    case FUNCTION_IDENTITY:
+        return "identity";
+    case FUNCTION_GAUSSIAN:
+        return "gaussian";
+    case FUNCTION_SIGMOID:
+        return "sigmoid";
+    case FUNCTION_COSINUS_APPROXIMATE:
+        return "cosinus (approximate)";
+    case FUNCTION_SINUS_APPROXIMATE:
+        return "sinus (approximate)";
+    case FUNCTION_TANH_APPROXIMATE:
+        return "tanh (approximate)";
+    case FUNCTION_GAUSSIAN_APPROXIMATE:
+        return "gaussian (approximate)";
+    case FUNCTION_SIGMOID_APPROXIMATE:
+        return "sigmoid (approximate)";
+    case FUNCTION_UNKNOWN:
+    default:
+        return "<unknown error>";
+    }
+}
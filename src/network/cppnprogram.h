@@ -0,0 +1,588 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPNPROGRAM_H
+#define CPPNPROGRAM_H
+
+#include <qnn-global.h>
+
+#include <network/commonnetworkfunctions.h>
+#include <network/cppnapproximations.h>
+
+#include <math.h>
+#include <cmath>
+#include <QList>
+#include <QVector>
+#include <QString>
+#include <QtCore/qmath.h>
+
+/*!
+ * \brief The CPPNProgram class is a decoded form of a CPPN gene.
+ *
+ * Decoding the gene is expensive compared to evaluating the network, so the gene is decoded once into a flat program.
+ * Every neuron stores its activation function and the range of its active connections.
+ * All active connections are stored in one contiguous array together with their decoded weight.
+ *
+ * The program produces exactly the same values as evaluating the gene directly.
+ * The evaluation functions are templates on the scalar type of the network. Evaluating with double gives the exact values,
+ * evaluating with float is faster but the values differ slightly (see ImageCPPNGeneratorNetwork::config::precision).
+ *
+ * The input neurons (bias, x, y, distance to center and optionally the time of an animation) occupy the first inputCount() places of the network.
+ * The neurons of the program follow directly afterwards, the last three neurons are the red, green and blue output.
+ *
+ * While decoding, every neuron is tagged with the coordinate inputs it depends on and with the evaluation stage it needs.
+ * Neurons which can not reach an output are not needed, neurons only depending on the bias are constant and neurons only depending
+ * on one coordinate input can be evaluated once per column, row or distance to the center instead of once per pixel.
+ */
+
+class QNNSHARED_EXPORT CPPNProgram
+{
+public:
+    /*!
+     * \brief The activation functions a neuron can use
+     */
+    enum activation_function {
+        FUNCTION_COSINUS,
+        FUNCTION_SINUS,
+        FUNCTION_TANH,
+        FUNCTION_IDENTITY,
+        FUNCTION_GAUSSIAN,
+        FUNCTION_SIGMOID,
+        FUNCTION_COSINUS_APPROXIMATE,
+        FUNCTION_SINUS_APPROXIMATE,
+        FUNCTION_TANH_APPROXIMATE,
+        FUNCTION_GAUSSIAN_APPROXIMATE,
+        FUNCTION_SIGMOID_APPROXIMATE,
+        FUNCTION_UNKNOWN
+    };
+
+    /*!
+     * \brief The accuracy of the activation functions
+     *
+     * ACCURACY_EXACT uses the std functions. ACCURACY_APPROXIMATE replaces cosinus, sinus, tanh, gaussian and sigmoid
+     * with the *_APPROXIMATE functions, which are evaluated using CPPNApproximations.
+     */
+    enum activation_accuracy {
+        ACCURACY_EXACT,
+        ACCURACY_APPROXIMATE
+    };
+
+    /*!
+     * \brief Flags for the coordinate inputs a neuron depends on
+     */
+    enum dependency {
+        DEPENDENCY_NONE = 0,
+        DEPENDENCY_X = 1,
+        DEPENDENCY_Y = 2,
+        DEPENDENCY_DISTANCE = 4
+    };
+
+    /*!
+     * \brief The stage in which a neuron has to be evaluated
+     */
+    enum evaluation_stage {
+        STAGE_CONSTANT,
+        STAGE_COLUMN,
+        STAGE_ROW,
+        STAGE_RADIUS,
+        STAGE_PIXEL,
+        STAGE_UNUSED,
+        STAGE_COUNT
+    };
+
+    /*!
+     * \brief An active connection of a neuron
+     */
+    struct connection {
+        /*!
+         * \brief Index of the source in the network (inputs first, then neurons)
+         */
+        qint32 input;
+
+        /*!
+         * \brief Decoded weight of the connection
+         */
+        double weight;
+    };
+
+    /*!
+     * \brief A decoded neuron
+     */
+    struct neuron {
+        /*!
+         * \brief Activation function of the neuron
+         */
+        activation_function function;
+
+        /*!
+         * \brief Index of the first connection of the neuron in connections()
+         */
+        qint32 first_connection;
+
+        /*!
+         * \brief Number of active connections of the neuron
+         */
+        qint32 connection_count;
+
+        /*!
+         * \brief Coordinate inputs the neuron depends on (combination of dependency flags)
+         */
+        qint32 dependencies;
+
+        /*!
+         * \brief Stage in which the neuron has to be evaluated
+         */
+        evaluation_stage stage;
+    };
+
+    /*!
+     * \brief Constructor for an empty program
+     */
+    CPPNProgram();
+
+    /*!
+     * \brief Decodes a CPPN gene into the program
+     *
+     * Every segment has to contain a function value followed by (activated, weight) pairs for all inputs and all previous neurons.
+     *
+     * \param segments Segments of the gene
+     * \param inputs Number of input neurons in front of the first segment
+     * \param accuracy Accuracy of the activation functions
+     */
+    void decode(QList< QList<qint32> > &segments, qint32 inputs, activation_accuracy accuracy = ACCURACY_EXACT);
+
+    /*!
+     * \brief Loads a program which was decoded before, e.g. from a GeneratorSnapshot
+     *
+     * The connections of neuron i follow the connections of neuron i - 1. Dependencies, evaluation stages and prefix hashes are
+     * calculated in the same way as by decode(), so the program is identical to the decoded program of the original gene.
+     *
+     * \param inputs Number of input neurons in front of the first neuron
+     * \param functions Activation function of every neuron
+     * \param connection_counts Number of active connections of every neuron
+     * \param neurons Number of neurons
+     * \param connection_inputs Source of every connection (inputs first, then neurons)
+     * \param connection_weights Weight of every connection
+     * \param connections Number of connections. Must be the sum of connection_counts
+     * \return True if the program is valid. If false the program is empty
+     */
+    bool load(qint32 inputs, const qint32 *functions, const qint32 *connection_counts, qint32 neurons, const qint32 *connection_inputs, const double *connection_weights, qint32 connections);
+
+    /*!
+     * \brief Returns the number of input neurons
+     * \return Number of input neurons
+     */
+    qint32 inputCount() const;
+
+    /*!
+     * \brief Returns the number of decoded neurons
+     * \return Number of decoded neurons, including the three output neurons
+     */
+    qint32 neuronCount() const;
+
+    /*!
+     * \brief Returns the size of the network array needed by evaluate()
+     * \return Number of inputs plus number of neurons
+     */
+    qint32 networkSize() const;
+
+    /*!
+     * \brief Returns the decoded neurons
+     * \return Decoded neurons
+     */
+    const QVector<neuron> &neurons() const;
+
+    /*!
+     * \brief Returns the active connections of all neurons
+     * \return Active connections
+     */
+    const QVector<connection> &connections() const;
+
+    /*!
+     * \brief Returns all neurons of an evaluation stage
+     * \param stage Evaluation stage
+     * \return Numbers of the neurons in ascending order
+     */
+    const QVector<qint32> &stageNeurons(evaluation_stage stage) const;
+
+    /*!
+     * \brief Returns the prefix hash of a neuron
+     *
+     * The prefix hash covers the number of inputs and the activation functions and active connections of the neurons 0 to i.
+     * Because neuron i only depends on the inputs and the neurons before it, two programs with the same prefix hash for
+     * neuron i calculate the same values for neuron i.
+     *
+     * \param i Number of the neuron (0 <= i < neuronCount())
+     * \return Prefix hash
+     */
+    quint64 prefixHash(qint32 i) const;
+
+    /*!
+     * \brief Combines a hash with a value
+     * \param hash Hash
+     * \param value Value
+     * \return New hash
+     */
+    static quint64 combineHash(quint64 hash, quint64 value);
+
+    /*!
+     * \brief Evaluates the program
+     *
+     * The caller has to set the inputs in the first inputCount() fields of network.
+     * All other fields are overwritten.
+     *
+     * \param network Array of size networkSize()
+     */
+    template<typename T> inline void evaluate(T *network) const;
+
+    /*!
+     * \brief Evaluates the program for BLOCK_SIZE pixels at once
+     *
+     * The network is stored as a structure of arrays: The values of neuron n for all pixels are stored in
+     * network[n * BLOCK_SIZE] to network[n * BLOCK_SIZE + BLOCK_SIZE - 1].
+     * This allows the compiler to vectorise the weighted sums and activation functions.
+     *
+     * For every pixel the result is identical to evaluate().
+     *
+     * The caller has to set the inputs in the first inputCount() * BLOCK_SIZE fields of network.
+     * All other fields are overwritten.
+     *
+     * \param network Array of size networkSize() * BLOCK_SIZE
+     */
+    template<typename T> inline void evaluateBlock(T *network) const;
+
+    /*!
+     * \brief Evaluates a subset of the neurons
+     *
+     * All neurons read by the given neurons have to be set in network.
+     *
+     * \param network Array of size networkSize()
+     * \param neurons Numbers of the neurons to evaluate in ascending order
+     */
+    template<typename T> inline void evaluateNeurons(T *network, const QVector<qint32> &neurons) const;
+
+    /*!
+     * \brief Evaluates a subset of the neurons for BLOCK_SIZE pixels at once
+     *
+     * The network is stored in the same way as for evaluateBlock().
+     * All neurons read by the given neurons have to be set in network.
+     *
+     * \param network Array of size networkSize() * BLOCK_SIZE
+     * \param neurons Numbers of the neurons to evaluate in ascending order
+     */
+    template<typename T> inline void evaluateNeuronsBlock(T *network, const QVector<qint32> &neurons) const;
+
+    /*!
+     * \brief Decodes a gene value to an activation function
+     * \param geneValue The gene value
+     * \return Activation function
+     */
+    static activation_function functionFromGene(qint32 geneValue);
+
+    /*!
+     * \brief Returns the approximate version of an activation function
+     * \param function Activation function
+     * \return The *_APPROXIMATE function. function if there is no approximate version
+     */
+    static activation_function approximateFunction(activation_function function);
+
+    /*!
+     * \brief Returns a human readable name of an activation function
+     * \param function Activation function
+     * \return Name of the function
+     */
+    static QString functionName(activation_function function);
+
+    /*!
+     * \brief Applies an activation function to value.
+     * \param value The internal value of the neuron
+     * \param function Activation function
+     * \return value with applied activation function
+     */
+    template<typename T> static inline T applyFunction(T value, activation_function function);
+
+    /*!
+     * \brief Applies an activation function to BLOCK_SIZE values
+     * \param values The internal values of the neurons. Will be overwritten with the result
+     * \param function Activation function
+     */
+    template<typename T> static inline void applyFunctionBlock(T *values, activation_function function);
+
+    /*!
+     * \brief Number of pixels evaluated at once by evaluateBlock()
+     */
+    static const qint32 BLOCK_SIZE = 16;
+
+    /*!
+     * \brief Index of the time input of animations (see ImageCPPNAnimationNetwork)
+     *
+     * The time is constant while a frame is rendered, so neurons only depending on the bias and the time are constant neurons
+     * and neurons depending on the time and one coordinate are evaluated per column, row or distance.
+     */
+    static const qint32 TIME_INPUT = 4;
+
+private:
+    /*!
+     * \brief Number of input neurons
+     */
+    qint32 _inputs;
+
+    /*!
+     * \brief Decoded neurons
+     */
+    QVector<neuron> _neurons;
+
+    /*!
+     * \brief Active connections of all neurons
+     */
+    QVector<connection> _connections;
+
+    /*!
+     * \brief Prefix hash of every neuron
+     */
+    QVector<quint64> _prefix_hashes;
+
+    /*!
+     * \brief Neurons of every evaluation stage
+     */
+    QVector<qint32> _stages[STAGE_COUNT];
+
+    /*!
+     * \brief Tags every neuron with its dependencies and evaluation stage
+     */
+    void analyse();
+
+    /*!
+     * \brief Evaluates a single neuron
+     * \param network Array of size networkSize()
+     * \param i Number of the neuron
+     */
+    template<typename T> inline void evaluateNeuron(T *network, qint32 i) const;
+
+    /*!
+     * \brief Evaluates a single neuron for BLOCK_SIZE pixels
+     * \param network Array of size networkSize() * BLOCK_SIZE
+     * \param i Number of the neuron
+     */
+    template<typename T> inline void evaluateNeuronBlock(T *network, qint32 i) const;
+
+    /*!
+     * \brief Sigmoid function in double precision. Identical to CommonNetworkFunctions::sigmoid()
+     * \param value Input
+     * \return Sigmoid of value
+     */
+    static inline double sigmoid(double value);
+
+    /*!
+     * \brief Sigmoid function in single precision
+     * \param value Input
+     * \return Sigmoid of value
+     */
+    static inline float sigmoid(float value);
+};
+
+template<typename T> void CPPNProgram::evaluate(T *network) const
+{
+    for(qint32 i = 0; i < _neurons.size(); ++i)
+    {
+        evaluateNeuron(network, i);
+    }
+}
+
+template<typename T> void CPPNProgram::evaluateBlock(T *network) const
+{
+    for(qint32 i = 0; i < _neurons.size(); ++i)
+    {
+        evaluateNeuronBlock(network, i);
+    }
+}
+
+template<typename T> void CPPNProgram::evaluateNeurons(T *network, const QVector<qint32> &neurons) const
+{
+    for(qint32 i = 0; i < neurons.size(); ++i)
+    {
+        evaluateNeuron(network, neurons[i]);
+    }
+}
+
+template<typename T> void CPPNProgram::evaluateNeuronsBlock(T *network, const QVector<qint32> &neurons) const
+{
+    for(qint32 i = 0; i < neurons.size(); ++i)
+    {
+        evaluateNeuronBlock(network, neurons[i]);
+    }
+}
+
+template<typename T> void CPPNProgram::evaluateNeuron(T *network, qint32 i) const
+{
+    const connection *connections = _connections.constData();
+    const neuron &n = _neurons[i];
+    T value = 0.0;
+    for(qint32 c = n.first_connection; c < n.first_connection + n.connection_count; ++c)
+    {
+        value += network[connections[c].input] * (T) connections[c].weight;
+    }
+    network[_inputs + i] = applyFunction(value, n.function);
+}
+
+template<typename T> void CPPNProgram::evaluateNeuronBlock(T *network, qint32 i) const
+{
+    const connection *connections = _connections.constData();
+    const neuron &n = _neurons[i];
+    T *value = network + (_inputs + i) * BLOCK_SIZE;
+    for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+    {
+        value[lane] = 0.0;
+    }
+    for(qint32 c = n.first_connection; c < n.first_connection + n.connection_count; ++c)
+    {
+        const T *input = network + connections[c].input * BLOCK_SIZE;
+        T weight = connections[c].weight;
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            value[lane] += input[lane] * weight;
+        }
+    }
+    applyFunctionBlock(value, n.function);
+}
+
+// The std functions are used instead of qCos() and friends because these only exist for double.
+// For double they are identical to the Qt functions.
+
+template<typename T> T CPPNProgram::applyFunction(T value, activation_function function)
+{
+    switch(function)
+    {
+    case FUNCTION_COSINUS:
+        return std::cos(value);
+    case FUNCTION_SINUS:
+        return std::sin(value);
+    case FUNCTION_TANH:
+        return std::tanh(value);
+    case FUNCTION_IDENTITY:
+        // Identity between 0,1
+        return qBound((T) 0.0, value, (T) 1.0);
+    case FUNCTION_GAUSSIAN:
+        // Identical to e^(-value^2 / 0.5), but without calling pow()
+        return std::exp((T) -2.0 * value * value);
+    case FUNCTION_SIGMOID:
+        return sigmoid(value);
+    case FUNCTION_COSINUS_APPROXIMATE:
+        return CPPNApproximations::cosinus(value);
+    case FUNCTION_SINUS_APPROXIMATE:
+        return CPPNApproximations::sinus(value);
+    case FUNCTION_TANH_APPROXIMATE:
+        return CPPNApproximations::tanh(value);
+    case FUNCTION_GAUSSIAN_APPROXIMATE:
+        return CPPNApproximations::gaussian(value);
+    case FUNCTION_SIGMOID_APPROXIMATE:
+        return CPPNApproximations::sigmoid(value);
+    case FUNCTION_UNKNOWN:
+    default:
+        return value;
+    }
+}
+
+template<typename T> void CPPNProgram::applyFunctionBlock(T *values, activation_function function)
+{
+    // The switch is hoisted out of the loops so every loop only contains a single operation
+    switch(function)
+    {
+    case FUNCTION_COSINUS:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = std::cos(values[lane]);
+        }
+        break;
+    case FUNCTION_SINUS:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = std::sin(values[lane]);
+        }
+        break;
+    case FUNCTION_TANH:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = std::tanh(values[lane]);
+        }
+        break;
+    case FUNCTION_IDENTITY:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = qBound((T) 0.0, values[lane], (T) 1.0);
+        }
+        break;
+    case FUNCTION_GAUSSIAN:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = std::exp((T) -2.0 * values[lane] * values[lane]);
+        }
+        break;
+    case FUNCTION_SIGMOID:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = sigmoid(values[lane]);
+        }
+        break;
+    case FUNCTION_COSINUS_APPROXIMATE:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = CPPNApproximations::cosinus(values[lane]);
+        }
+        break;
+    case FUNCTION_SINUS_APPROXIMATE:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = CPPNApproximations::sinus(values[lane]);
+        }
+        break;
+    case FUNCTION_TANH_APPROXIMATE:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = CPPNApproximations::tanh(values[lane]);
+        }
+        break;
+    case FUNCTION_GAUSSIAN_APPROXIMATE:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = CPPNApproximations::gaussian(values[lane]);
+        }
+        break;
+    case FUNCTION_SIGMOID_APPROXIMATE:
+        for(qint32 lane = 0; lane < BLOCK_SIZE; ++lane)
+        {
+            values[lane] = CPPNApproximations::sigmoid(values[lane]);
+        }
+        break;
+    case FUNCTION_UNKNOWN:
+    default:
+        break;
+    }
+}
+
+double CPPNProgram::sigmoid(double value)
+{
+    return CommonNetworkFunctions::sigmoid(value);
+}
+
+float CPPNProgram::sigmoid(float value)
+{
+    return 1.0f / (1.0f + std::exp(-value));
+}
+
+#endif // CPPNPROGRAM_H
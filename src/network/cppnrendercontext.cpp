@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cppnrendercontext.h"
+
+CPPNRenderContext::CPPNRenderContext() :
+    _coordinates(),
+    _slots(),
+    _workers(),
+    _separable()
+{
+}
+
+void CPPNRenderContext::prepare(qint32 width, qint32 height, qint32 network_size, qint32 band_height, qint32 workers)
+{
+    if(Q_UNLIKELY(workers <= 0))
+    {
+        QNN_FATAL_MSG("At least one worker is needed");
+    }
+    if(_coordinates.isNull() || _coordinates->width() != width || _coordinates->height() != height)
+    {
+        _coordinates = CPPNCoordinates::get(width, height);
+        _separable.reset();
+    }
+    if(_workers.size() != workers)
+    {
+        _slots.resize(qMax(_slots.size(), workers));
+        _workers.resize(workers);
+        for(qint32 worker = 0; worker < workers; ++worker)
+        {
+            _workers[worker] = worker;
+        }
+    }
+
+    // The network arrays are big enough for batch evaluation in both precisions
+    for(qint32 worker = 0; worker < workers; ++worker)
+    {
+        scratch &s = _slots[worker];
+        s.network<double>(network_size * CPPNProgram::BLOCK_SIZE);
+        s.network<float>(network_size * CPPNProgram::BLOCK_SIZE);
+        s.distance(width);
+        s.radius(width);
+        s.pixels(width * qMin(band_height, height));
+    }
+}
+
+const CPPNCoordinates &CPPNRenderContext::coordinates() const
+{
+    return *_coordinates;
+}
+
+qint32 CPPNRenderContext::workerCount() const
+{
+    return _workers.size();
+}
+
+QVector<qint32> &CPPNRenderContext::workers()
+{
+    return _workers;
+}
+
+CPPNRenderContext::scratch &CPPNRenderContext::slot(qint32 worker)
+{
+    return _slots[worker];
+}
+
+const CPPNSeparableValues *CPPNRenderContext::separable(const CPPNProgram &program, bool single_precision)
+{
+    if(_separable.isNull() || &_separable->program() != &program)
+    {
+        _separable.reset(new CPPNSeparableValues(program, *_coordinates, 0.0, single_precision));
+    }
+    else
+    {
+        _separable->calculate(*_coordinates, 0.0, single_precision);
+    }
+    return _separable.data();
+}
+
+void CPPNRenderContext::prepareImage(QImage &image, qint32 width, qint32 height)
+{
+    if(image.width() != width || image.height() != height || image.format() != QImage::Format_RGB32 || !image.isDetached())
+    {
+        image = QImage(width, height, QImage::Format_RGB32);
+    }
+}
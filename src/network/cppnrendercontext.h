@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPNRENDERCONTEXT_H
+#define CPPNRENDERCONTEXT_H
+
+#include <qnn-global.h>
+
+#include <network/cppnprogram.h>
+#include <network/cppncoordinates.h>
+#include <network/cppnseparablevalues.h>
+
+#include <QImage>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QVector>
+
+/*!
+ * \brief The CPPNRenderContext class keeps all memory needed to render a CPPN image between evaluations.
+ *
+ * Every ImageCPPNGeneratorNetwork owns a render context. The scratch arrays of the evaluation, the separable values and the coordinates
+ * are kept after an evaluation and reused by the next one, so evaluating a network again does not allocate any memory.
+ * The arrays only grow, e.g. if the network is initialised with a bigger gene or the configuration changes.
+ *
+ * For parallel rendering there is one scratch slot per worker. The workers take the bands of the image from a shared counter,
+ * so the number of slots does not depend on the number of bands.
+ *
+ * The context is not thread safe, only the slots may be used by different threads at the same time.
+ */
+
+class QNNSHARED_EXPORT CPPNRenderContext
+{
+public:
+    /*!
+     * \brief Scratch memory used by one thread while rendering rows
+     *
+     * All functions return arrays of at least the requested size. The arrays are only reallocated if they are too small.
+     * The content of the arrays is not preserved between calls.
+     */
+    struct scratch {
+        /*!
+         * \brief Returns the network array
+         * \param size Number of values (CPPNProgram::networkSize(), times CPPNProgram::BLOCK_SIZE for batch evaluation)
+         * \return Array of at least size values
+         */
+        template<typename T> inline T *network(qint32 size);
+
+        /*!
+         * \brief Returns an array for the distances of a row (see CPPNCoordinates::distanceRow())
+         * \param width Width of the image
+         * \return Array of at least width values
+         */
+        inline double *distance(qint32 width);
+
+        /*!
+         * \brief Returns an array for the distance numbers of a row (see CPPNCoordinates::radiusIndexRow())
+         * \param width Width of the image
+         * \return Array of at least width values
+         */
+        inline qint32 *radius(qint32 width);
+
+        /*!
+         * \brief Returns an array for rendered pixels which are not written into an image
+         * \param pixels Number of pixels
+         * \return Array of at least pixels values
+         */
+        inline QRgb *pixels(qint32 pixels);
+
+        /*!
+         * \brief Resizes vector if it is smaller than size
+         * \param vector Vector to grow
+         * \param size Minimum size
+         * \return Data of the vector
+         */
+        template<typename T> static inline T *grow(QVector<T> &vector, qint32 size);
+
+        /*!
+         * \brief Network array for PRECISION_DOUBLE
+         */
+        QVector<double> network_double;
+
+        /*!
+         * \brief Network array for PRECISION_FLOAT
+         */
+        QVector<float> network_float;
+
+        /*!
+         * \brief Distances of a row
+         */
+        QVector<double> distance_row;
+
+        /*!
+         * \brief Distance numbers of a row
+         */
+        QVector<qint32> radius_row;
+
+        /*!
+         * \brief Rendered pixels
+         */
+        QVector<QRgb> pixel_buffer;
+    };
+
+    /*!
+     * \brief Constructor. No memory is allocated before the first call of prepare()
+     */
+    CPPNRenderContext();
+
+    /*!
+     * \brief Allocates all memory needed to render an image
+     *
+     * Does nothing if the memory of an earlier call is big enough.
+     *
+     * \param width Width of the image
+     * \param height Height of the image
+     * \param network_size Biggest network size which will be rendered (CPPNProgram::networkSize())
+     * \param band_height Height of the bands
+     * \param workers Number of threads rendering at the same time. Must be greater than 0
+     */
+    void prepare(qint32 width, qint32 height, qint32 network_size, qint32 band_height, qint32 workers);
+
+    /*!
+     * \brief Returns the coordinates of the image size passed to prepare()
+     * \return Coordinates
+     */
+    const CPPNCoordinates &coordinates() const;
+
+    /*!
+     * \brief Returns the number of scratch slots
+     * \return Number of workers passed to prepare()
+     */
+    qint32 workerCount() const;
+
+    /*!
+     * \brief Returns the numbers of all workers
+     *
+     * The vector can be passed to QtConcurrent::blockingMap() to start one task per worker.
+     *
+     * \return Vector containing 0 to workerCount() - 1
+     */
+    QVector<qint32> &workers();
+
+    /*!
+     * \brief Returns the scratch slot of a worker
+     * \param worker Number of the worker (0 <= worker < workerCount())
+     * \return Scratch of the worker
+     */
+    scratch &slot(qint32 worker);
+
+    /*!
+     * \brief Calculates the separable values of a program for the image size passed to prepare()
+     *
+     * The values are stored in the context and reused if the function is called again for the same program.
+     *
+     * \param program Decoded network. Must outlive the context
+     * \param single_precision If true the values are calculated as float (see CPPNSeparableValues)
+     * \return Separable values, valid until the next call
+     */
+    const CPPNSeparableValues *separable(const CPPNProgram &program, bool single_precision);
+
+    /*!
+     * \brief Makes image a writable image of the given size in Format_RGB32
+     *
+     * The memory of image is reused if it has the right size and format and is not shared with another QImage
+     * (e.g. an image returned by getImage() which is still in use, an image in a ImageRenderCache or an image saved on a background thread).
+     * Otherwise a new image is allocated, so shared images are never modified.
+     *
+     * \param image Image to prepare
+     * \param width Width of the image
+     * \param height Height of the image
+     */
+    static void prepareImage(QImage &image, qint32 width, qint32 height);
+
+private:
+    /*!
+     * \brief Coordinates of the current image size
+     */
+    QSharedPointer<const CPPNCoordinates> _coordinates;
+
+    /*!
+     * \brief Scratch slots of all workers
+     */
+    QVector<scratch> _slots;
+
+    /*!
+     * \brief Numbers of all workers
+     */
+    QVector<qint32> _workers;
+
+    /*!
+     * \brief Separable values of the last program
+     */
+    QScopedPointer<CPPNSeparableValues> _separable;
+};
+
+template<typename T> T *CPPNRenderContext::scratch::grow(QVector<T> &vector, qint32 size)
+{
+    if(vector.size() < size)
+    {
+        vector.resize(size);
+    }
+    return vector.data();
+}
+
+template<> inline double *CPPNRenderContext::scratch::network<double>(qint32 size)
+{
+    return grow(network_double, size);
+}
+
+template<> inline float *CPPNRenderContext::scratch::network<float>(qint32 size)
+{
+    return grow(network_float, size);
+}
+
+double *CPPNRenderContext::scratch::distance(qint32 width)
+{
+    return grow(distance_row, width);
+}
+
+qint32 *CPPNRenderContext::scratch::radius(qint32 width)
+{
+    return grow(radius_row, width);
+}
+
+QRgb *CPPNRenderContext::scratch::pixels(qint32 pixels)
+{
+    return grow(pixel_buffer, pixels);
+}
+
+#endif // CPPNRENDERCONTEXT_H
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cppnseparablevalues.h"
+
+#include <algorithm>
+
+CPPNSeparableValues::CPPNSeparableValues(const CPPNProgram &program, const CPPNCoordinates &coordinates, double time, bool single_precision) :
+    _program(program),
+    _radius_available(false),
+    _single_precision(single_precision),
+    _pixel_neurons(),
+    _precalculated_connections(0),
+    _values(),
+    _network(),
+    _float_values(),
+    _float_network()
+{
+    calculate(coordinates, time, single_precision);
+}
+
+void CPPNSeparableValues::calculate(const CPPNCoordinates &coordinates, double time, bool single_precision)
+{
+    const CPPNProgram &program = _program;
+    _radius_available = coordinates.radiusCount() > 0;
+    _single_precision = single_precision;
+    _precalculated_connections = 0;
+
+    // resize() keeps the allocated memory, so the vectors are only reallocated if they grow
+    const QVector<qint32> &pixel_neurons = program.stageNeurons(CPPNProgram::STAGE_PIXEL);
+    _pixel_neurons.resize(pixel_neurons.size());
+    std::copy(pixel_neurons.constBegin(), pixel_neurons.constEnd(), _pixel_neurons.begin());
+
+    if(_single_precision)
+    {
+        calculateStages(_float_values, _float_network, coordinates, time);
+    }
+    else
+    {
+        calculateStages(_values, _network, coordinates, time);
+    }
+
+    if(!_radius_available)
+    {
+        _pixel_neurons += program.stageNeurons(CPPNProgram::STAGE_RADIUS);
+        std::sort(_pixel_neurons.begin(), _pixel_neurons.end());
+    }
+}
+
+const CPPNProgram &CPPNSeparableValues::program() const
+{
+    return _program;
+}
+
+const QVector<qint32> &CPPNSeparableValues::pixelNeurons() const
+{
+    return _pixel_neurons;
+}
+
+bool CPPNSeparableValues::radiusAvailable() const
+{
+    return _radius_available;
+}
+
+bool CPPNSeparableValues::singlePrecision() const
+{
+    return _single_precision;
+}
+
+qint64 CPPNSeparableValues::connectionEvaluations(qint64 pixels) const
+{
+    qint64 connections = 0;
+    for(qint32 i = 0; i < _pixel_neurons.size(); ++i)
+    {
+        connections += _program.neurons()[_pixel_neurons[i]].connection_count;
+    }
+    return _precalculated_connections + connections * pixels;
+}
+
+template<typename T> void CPPNSeparableValues::calculateStages(QVector<T> *values, QVector<T> &network_vector, const CPPNCoordinates &coordinates, double time)
+{
+    network_vector.resize(_program.networkSize());
+    std::fill(network_vector.begin(), network_vector.end(), (T) 0.0);
+    T *network = network_vector.data();
+    double constant = 1.0;
+    network[0] = 1.0;
+    if(_program.inputCount() > CPPNProgram::TIME_INPUT)
+    {
+        network[CPPNProgram::TIME_INPUT] = time;
+    }
+
+    calculateStage(values, network, CPPNProgram::STAGE_CONSTANT, 0, &constant, 1);
+    // The constant neurons stay in the network, all other stages only read them
+    setValues(network, CPPNProgram::STAGE_CONSTANT, 0);
+    calculateStage(values, network, CPPNProgram::STAGE_COLUMN, 1, coordinates.x(), coordinates.width());
+    calculateStage(values, network, CPPNProgram::STAGE_ROW, 2, coordinates.y(), coordinates.height());
+
+    if(_radius_available)
+    {
+        calculateStage(values, network, CPPNProgram::STAGE_RADIUS, 3, coordinates.radii(), coordinates.radiusCount());
+    }
+    else
+    {
+        values[CPPNProgram::STAGE_RADIUS].resize(0);
+    }
+}
+
+template<typename T> void CPPNSeparableValues::calculateStage(QVector<T> *values, T *network, CPPNProgram::evaluation_stage stage, qint32 input, const double *inputs, qint32 count)
+{
+    const QVector<qint32> &neurons = _program.stageNeurons(stage);
+    QVector<T> &stage_values = values[stage];
+    stage_values.resize(neurons.size() * count);
+    if(neurons.isEmpty())
+    {
+        return;
+    }
+
+    for(qint32 i = 0; i < neurons.size(); ++i)
+    {
+        _precalculated_connections += (qint64) _program.neurons()[neurons[i]].connection_count * count;
+    }
+
+    for(qint32 index = 0; index < count; ++index)
+    {
+        // The input is converted to T in the same way as by the pixel wise evaluation
+        network[input] = inputs[index];
+        _program.evaluateNeurons(network, neurons);
+        for(qint32 i = 0; i < neurons.size(); ++i)
+        {
+            stage_values[index * neurons.size() + i] = network[_program.inputCount() + neurons[i]];
+        }
+    }
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPPNSEPARABLEVALUES_H
+#define CPPNSEPARABLEVALUES_H
+
+#include <qnn-global.h>
+
+#include <network/cppnprogram.h>
+#include <network/cppncoordinates.h>
+
+#include <QVector>
+
+/*!
+ * \brief The CPPNSeparableValues class contains the precalculated values of all neurons of a CPPNProgram which do not depend on both coordinates.
+ *
+ * Constant neurons are calculated once, neurons only depending on x once per column, neurons only depending on y once per row
+ * and neurons only depending on the distance to the center once per distinct distance (see CPPNCoordinates::radiusCount()).
+ * If the distances are not numbered, the distance neurons are evaluated per pixel together with the remaining neurons.
+ *
+ * While rendering the values are copied into the network with setValues() or setValuesBlock() and only pixelNeurons() are evaluated.
+ * The values are calculated with the same operations and in the same scalar type as CPPNProgram::evaluate(), so the rendered image is identical
+ * in both precisions. The scalar type is selected with single_precision, setValues() and setValuesBlock() must be used with the same type.
+ */
+
+class QNNSHARED_EXPORT CPPNSeparableValues
+{
+public:
+    /*!
+     * \brief Constructor. Calculates all values
+     * \param program Decoded network. Must outlive the object
+     * \param coordinates Coordinate inputs for the size of the image
+     * \param time Value of the time input (see CPPNProgram::TIME_INPUT). Ignored if the program has no time input
+     * \param single_precision If true the values are calculated as float, otherwise as double
+     */
+    CPPNSeparableValues(const CPPNProgram &program, const CPPNCoordinates &coordinates, double time = 0.0, bool single_precision = false);
+
+    /*!
+     * \brief Calculates all values again for the current state of the program
+     *
+     * The memory of the previous values is reused, so recalculating the values for a program decoded from a new gene of similar size
+     * does not allocate (see CPPNRenderContext).
+     *
+     * \param coordinates Coordinate inputs for the size of the image
+     * \param time Value of the time input (see CPPNProgram::TIME_INPUT). Ignored if the program has no time input
+     * \param single_precision If true the values are calculated as float, otherwise as double
+     */
+    void calculate(const CPPNCoordinates &coordinates, double time = 0.0, bool single_precision = false);
+
+    /*!
+     * \brief Returns the program the values are calculated for
+     * \return Program passed to the constructor
+     */
+    const CPPNProgram &program() const;
+
+    /*!
+     * \brief Returns the neurons which have to be evaluated for every pixel
+     * \return Numbers of the neurons in ascending order
+     */
+    const QVector<qint32> &pixelNeurons() const;
+
+    /*!
+     * \brief Returns if the distance neurons are precalculated
+     * \return True if the distance neurons are precalculated
+     */
+    bool radiusAvailable() const;
+
+    /*!
+     * \brief Returns if the values are calculated as float
+     * \return True if the values are calculated as float, false if they are calculated as double
+     */
+    bool singlePrecision() const;
+
+    /*!
+     * \brief Returns the number of connections evaluated to render an image with these values
+     * \param pixels Number of pixels of the image
+     * \return Evaluated connections, including the precalculation
+     */
+    qint64 connectionEvaluations(qint64 pixels) const;
+
+    /*!
+     * \brief Copies the values of a stage into the network
+     * \param network Array of size CPPNProgram::networkSize(). T must be float if singlePrecision() is true and double otherwise
+     * \param stage Evaluation stage (STAGE_CONSTANT, STAGE_COLUMN, STAGE_ROW or STAGE_RADIUS)
+     * \param index Column, row or distance number. Ignored for STAGE_CONSTANT
+     */
+    template<typename T> inline void setValues(T *network, CPPNProgram::evaluation_stage stage, qint32 index) const;
+
+    /*!
+     * \brief Copies the values of a stage into one lane of a network used by CPPNProgram::evaluateNeuronsBlock()
+     * \param network Array of size CPPNProgram::networkSize() * CPPNProgram::BLOCK_SIZE. T must be float if singlePrecision() is true and double otherwise
+     * \param stage Evaluation stage (STAGE_CONSTANT, STAGE_COLUMN, STAGE_ROW or STAGE_RADIUS)
+     * \param index Column, row or distance number. Ignored for STAGE_CONSTANT
+     * \param lane Lane of the block
+     */
+    template<typename T> inline void setValuesBlock(T *network, CPPNProgram::evaluation_stage stage, qint32 index, qint32 lane) const;
+
+private:
+    const CPPNProgram &_program;
+    bool _radius_available;
+    bool _single_precision;
+    QVector<qint32> _pixel_neurons;
+    qint64 _precalculated_connections;
+    QVector<double> _values[CPPNProgram::STAGE_RADIUS + 1];
+    QVector<double> _network;
+    QVector<float> _float_values[CPPNProgram::STAGE_RADIUS + 1];
+    QVector<float> _float_network;
+
+    template<typename T> void calculateStages(QVector<T> *values, QVector<T> &network, const CPPNCoordinates &coordinates, double time);
+    template<typename T> void calculateStage(QVector<T> *values, T *network, CPPNProgram::evaluation_stage stage, qint32 input, const double *inputs, qint32 count);
+    template<typename T> inline const QVector<T> &stageValues(CPPNProgram::evaluation_stage stage) const;
+};
+
+template<> inline const QVector<double> &CPPNSeparableValues::stageValues<double>(CPPNProgram::evaluation_stage stage) const
+{
+    Q_ASSERT(!_single_precision);
+    return _values[stage];
+}
+
+template<> inline const QVector<float> &CPPNSeparableValues::stageValues<float>(CPPNProgram::evaluation_stage stage) const
+{
+    Q_ASSERT(_single_precision);
+    return _float_values[stage];
+}
+
+template<typename T> void CPPNSeparableValues::setValues(T *network, CPPNProgram::evaluation_stage stage, qint32 index) const
+{
+    const QVector<qint32> &neurons = _program.stageNeurons(stage);
+    const T *values = stageValues<T>(stage).constData() + index * neurons.size();
+    T *destination = network + _program.inputCount();
+    for(qint32 i = 0; i < neurons.size(); ++i)
+    {
+        destination[neurons[i]] = values[i];
+    }
+}
+
+template<typename T> void CPPNSeparableValues::setValuesBlock(T *network, CPPNProgram::evaluation_stage stage, qint32 index, qint32 lane) const
+{
+    const QVector<qint32> &neurons = _program.stageNeurons(stage);
+    const T *values = stageValues<T>(stage).constData() + index * neurons.size();
+    T *destination = network + _program.inputCount() * CPPNProgram::BLOCK_SIZE + lane;
+    for(qint32 i = 0; i < neurons.size(); ++i)
+    {
+        destination[neurons[i] * CPPNProgram::BLOCK_SIZE] = values[i];
+    }
+}
+
+#endif // CPPNSEPARABLEVALUES_H
@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "generatorsnapshot.h"
+
+#include <string.h>
+#include <QSaveFile>
+
+static const char SNAPSHOT_MAGIC[8] = {'Q', 'N', 'N', 'I', 'G', 'S', 'N', 'P'};
+
+GeneratorSnapshot::GeneratorSnapshot() :
+    _file(),
+    _header(NULL),
+    _program()
+{
+}
+
+bool GeneratorSnapshot::open(const QString &path)
+{
+    close();
+    QSharedPointer<QFile> file(new QFile(path));
+    if(!file->open(QIODevice::ReadOnly))
+    {
+        QNN_WARNING_MSG(QString("Could not open %1").arg(path));
+        return false;
+    }
+    qint64 size = file->size();
+    const uchar *data = size > 0 ? file->map(0, size) : NULL;
+    if(data == NULL)
+    {
+        QNN_WARNING_MSG(QString("Could not map %1").arg(path));
+        return false;
+    }
+    if(!load(data, size))
+    {
+        return false;
+    }
+    _file = file;
+    return true;
+}
+
+bool GeneratorSnapshot::load(const uchar *data, qint64 size)
+{
+    close();
+    if(Q_UNLIKELY(size < (qint64) sizeof(header)))
+    {
+        QNN_WARNING_MSG("Snapshot is too small");
+        return false;
+    }
+    if(Q_UNLIKELY(reinterpret_cast<quintptr>(data) % 8 != 0))
+    {
+        QNN_WARNING_MSG("Snapshot is not aligned to 8 bytes");
+        return false;
+    }
+
+    const header *h = reinterpret_cast<const header *>(data);
+    if(Q_UNLIKELY(memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0))
+    {
+        QNN_WARNING_MSG("Data is not a snapshot");
+        return false;
+    }
+    if(Q_UNLIKELY(h->byte_order != BYTE_ORDER_MARK))
+    {
+        QNN_WARNING_MSG("Snapshot was written with another byte order");
+        return false;
+    }
+    if(Q_UNLIKELY(h->version != VERSION))
+    {
+        QNN_WARNING_MSG(QString("Snapshot version %1 is not supported").arg(h->version));
+        return false;
+    }
+    if(Q_UNLIKELY(h->header_size != sizeof(header) || h->size < sizeof(header) || h->size > (quint64) size || h->size % 8 != 0 || h->width <= 0 || h->height <= 0))
+    {
+        QNN_WARNING_MSG("Snapshot is corrupt");
+        return false;
+    }
+    _header = h;
+
+    bool valid = false;
+    switch(h->type)
+    {
+    case SNAPSHOT_CPPN:
+        valid = h->inputs == ImageCPPNGeneratorNetwork::INPUT_NEURONS && h->neurons >= 3 && h->connections >= 0 &&
+                (h->precision == ImageCPPNGeneratorNetwork::PRECISION_DOUBLE || h->precision == ImageCPPNGeneratorNetwork::PRECISION_FLOAT) &&
+                h->supersampling_samples > 0 && h->supersampling_threshold >= 0 &&
+                checkSection(SECTION_FUNCTIONS, h->neurons * (qint64) sizeof(qint32)) &&
+                checkSection(SECTION_CONNECTION_COUNTS, h->neurons * (qint64) sizeof(qint32)) &&
+                checkSection(SECTION_CONNECTION_INPUTS, h->connections * (qint64) sizeof(qint32)) &&
+                checkSection(SECTION_CONNECTION_WEIGHTS, h->connections * (qint64) sizeof(double));
+        valid = valid && _program.load(h->inputs,
+                                       reinterpret_cast<const qint32 *>(section(SECTION_FUNCTIONS)),
+                                       reinterpret_cast<const qint32 *>(section(SECTION_CONNECTION_COUNTS)),
+                                       h->neurons,
+                                       reinterpret_cast<const qint32 *>(section(SECTION_CONNECTION_INPUTS)),
+                                       reinterpret_cast<const double *>(section(SECTION_CONNECTION_WEIGHTS)),
+                                       h->connections);
+        break;
+    case SNAPSHOT_DIRECT_ENCODING:
+        valid = h->genome_width > 0 && h->genome_width <= h->width && h->genome_height > 0 && h->genome_height <= h->height &&
+                (h->interpolation == ImageUpsampler::INTERPOLATION_NEAREST || h->interpolation == ImageUpsampler::INTERPOLATION_BILINEAR || h->interpolation == ImageUpsampler::INTERPOLATION_BICUBIC) &&
+                checkSection(SECTION_PIXELS, (qint64) h->genome_width * h->genome_height * 3);
+        break;
+    default:
+        break;
+    }
+    if(!valid)
+    {
+        QNN_WARNING_MSG("Snapshot is corrupt");
+        close();
+        return false;
+    }
+    return true;
+}
+
+void GeneratorSnapshot::close()
+{
+    _file.clear();
+    _header = NULL;
+    _program = CPPNProgram();
+}
+
+bool GeneratorSnapshot::isValid() const
+{
+    return _header != NULL;
+}
+
+GeneratorSnapshot::snapshot_type GeneratorSnapshot::type() const
+{
+    return _header == NULL ? SNAPSHOT_INVALID : (snapshot_type) _header->type;
+}
+
+qint64 GeneratorSnapshot::size() const
+{
+    return _header == NULL ? 0 : _header->size;
+}
+
+qint32 GeneratorSnapshot::width() const
+{
+    return _header == NULL ? 0 : _header->width;
+}
+
+qint32 GeneratorSnapshot::height() const
+{
+    return _header == NULL ? 0 : _header->height;
+}
+
+const CPPNProgram &GeneratorSnapshot::program() const
+{
+    return _program;
+}
+
+ImageCPPNGeneratorNetwork::config GeneratorSnapshot::cppnConfig() const
+{
+    ImageCPPNGeneratorNetwork::config config;
+    config.save_image = false;
+    if(type() == SNAPSHOT_CPPN)
+    {
+        config.width = _header->width;
+        config.height = _header->height;
+        config.precision = (ImageCPPNGeneratorNetwork::evaluation_precision) _header->precision;
+        config.supersampling_samples = _header->supersampling_samples;
+        config.supersampling_threshold = _header->supersampling_threshold;
+    }
+    return config;
+}
+
+qint32 GeneratorSnapshot::genomeWidth() const
+{
+    return type() == SNAPSHOT_DIRECT_ENCODING ? _header->genome_width : 0;
+}
+
+qint32 GeneratorSnapshot::genomeHeight() const
+{
+    return type() == SNAPSHOT_DIRECT_ENCODING ? _header->genome_height : 0;
+}
+
+ImageUpsampler::interpolation_mode GeneratorSnapshot::interpolation() const
+{
+    return type() == SNAPSHOT_DIRECT_ENCODING ? (ImageUpsampler::interpolation_mode) _header->interpolation : ImageUpsampler::INTERPOLATION_BILINEAR;
+}
+
+const uchar *GeneratorSnapshot::pixels() const
+{
+    return type() == SNAPSHOT_DIRECT_ENCODING ? section(SECTION_PIXELS) : NULL;
+}
+
+QImage GeneratorSnapshot::image(qint32 width, qint32 height) const
+{
+    if(Q_UNLIKELY(_header == NULL))
+    {
+        QNN_WARNING_MSG("No snapshot loaded");
+        return QImage();
+    }
+    if(Q_UNLIKELY(width < 0 || height < 0))
+    {
+        QNN_WARNING_MSG("Width and height must not be negative");
+        return QImage();
+    }
+    width = width == 0 ? _header->width : width;
+    height = height == 0 ? _header->height : height;
+
+    if(_header->type == SNAPSHOT_CPPN)
+    {
+        ImageCPPNGeneratorNetwork::config config = cppnConfig();
+        config.width = width;
+        config.height = height;
+        return ImageCPPNGeneratorNetwork::renderProgram(_program, config);
+    }
+
+    if(_header->genome_width == width && _header->genome_height == height)
+    {
+        if(_file.isNull())
+        {
+            return QImage(pixels(), width, height, width * 3, QImage::Format_RGB888);
+        }
+        return QImage(pixels(), width, height, width * 3, QImage::Format_RGB888, &releaseFile, new QSharedPointer<QFile>(_file));
+    }
+    ImageUpsampler upsampler(_header->genome_width, _header->genome_height, width, height, interpolation());
+    return upsampler.image(pixels());
+}
+
+QByteArray GeneratorSnapshot::fromCPPN(const CPPNProgram &program, const ImageCPPNGeneratorNetwork::config &config)
+{
+    const QVector<CPPNProgram::neuron> &neurons = program.neurons();
+    const QVector<CPPNProgram::connection> &connections = program.connections();
+    qint64 sizes[SECTION_COUNT];
+    sizes[SECTION_FUNCTIONS] = neurons.size() * (qint64) sizeof(qint32);
+    sizes[SECTION_CONNECTION_COUNTS] = neurons.size() * (qint64) sizeof(qint32);
+    sizes[SECTION_CONNECTION_INPUTS] = connections.size() * (qint64) sizeof(qint32);
+    sizes[SECTION_CONNECTION_WEIGHTS] = connections.size() * (qint64) sizeof(double);
+
+    QByteArray snapshot = createSnapshot(SNAPSHOT_CPPN, sizes);
+    header *h = reinterpret_cast<header *>(snapshot.data());
+    h->width = config.width;
+    h->height = config.height;
+    h->inputs = program.inputCount();
+    h->neurons = neurons.size();
+    h->connections = connections.size();
+    h->precision = config.precision;
+    h->supersampling_samples = config.supersampling_samples;
+    h->supersampling_threshold = config.supersampling_threshold;
+
+    qint32 *functions = reinterpret_cast<qint32 *>(snapshot.data() + h->sections[SECTION_FUNCTIONS]);
+    qint32 *connection_counts = reinterpret_cast<qint32 *>(snapshot.data() + h->sections[SECTION_CONNECTION_COUNTS]);
+    for(qint32 i = 0; i < neurons.size(); ++i)
+    {
+        functions[i] = neurons[i].function;
+        connection_counts[i] = neurons[i].connection_count;
+    }
+    qint32 *connection_inputs = reinterpret_cast<qint32 *>(snapshot.data() + h->sections[SECTION_CONNECTION_INPUTS]);
+    double *connection_weights = reinterpret_cast<double *>(snapshot.data() + h->sections[SECTION_CONNECTION_WEIGHTS]);
+    for(qint32 c = 0; c < connections.size(); ++c)
+    {
+        connection_inputs[c] = connections[c].input;
+        connection_weights[c] = connections[c].weight;
+    }
+    return snapshot;
+}
+
+QByteArray GeneratorSnapshot::fromDirectEncoding(const uchar *pixels, qint32 genome_width, qint32 genome_height, const ImageDirectEncodingGeneratorNetwork::config &config)
+{
+    qint64 sizes[SECTION_COUNT] = {0, 0, 0, 0};
+    sizes[SECTION_PIXELS] = (qint64) genome_width * genome_height * 3;
+
+    QByteArray snapshot = createSnapshot(SNAPSHOT_DIRECT_ENCODING, sizes);
+    header *h = reinterpret_cast<header *>(snapshot.data());
+    h->width = config.width;
+    h->height = config.height;
+    h->genome_width = genome_width;
+    h->genome_height = genome_height;
+    h->interpolation = config.interpolation;
+    memcpy(snapshot.data() + h->sections[SECTION_PIXELS], pixels, sizes[SECTION_PIXELS]);
+    return snapshot;
+}
+
+bool GeneratorSnapshot::write(const QByteArray &snapshot, const QString &path)
+{
+    // The snapshot is written to a temporary file which only replaces path when it is complete,
+    // so a failed write never leaves a truncated snapshot and snapshots mapped by other processes stay valid
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        QNN_WARNING_MSG(QString("Could not open %1").arg(path));
+        return false;
+    }
+    if(file.write(snapshot) != snapshot.size())
+    {
+        QNN_WARNING_MSG(QString("Could not write to %1").arg(path));
+        file.cancelWriting();
+        return false;
+    }
+    if(!file.commit())
+    {
+        QNN_WARNING_MSG(QString("Could not write to %1").arg(path));
+        return false;
+    }
+    return true;
+}
+
+QByteArray GeneratorSnapshot::createSnapshot(snapshot_type type, const qint64 *sizes)
+{
+    quint64 offsets[SECTION_COUNT];
+    qint64 size = sizeof(header);
+    for(qint32 i = 0; i < SECTION_COUNT; ++i)
+    {
+        offsets[i] = sizes[i] > 0 ? size : 0;
+        size += (sizes[i] + 7) / 8 * 8;
+    }
+
+    QByteArray snapshot(size, '\0');
+    header *h = reinterpret_cast<header *>(snapshot.data());
+    memcpy(h->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    h->byte_order = BYTE_ORDER_MARK;
+    h->version = VERSION;
+    h->type = type;
+    h->header_size = sizeof(header);
+    h->size = size;
+    memcpy(h->sections, offsets, sizeof(offsets));
+    return snapshot;
+}
+
+bool GeneratorSnapshot::checkSection(snapshot_section section, qint64 bytes) const
+{
+    if(bytes == 0)
+    {
+        return true;
+    }
+    quint64 offset = _header->sections[section];
+    return offset >= sizeof(header) && offset % 8 == 0 && offset <= _header->size && (quint64) bytes <= _header->size - offset;
+}
+
+const uchar *GeneratorSnapshot::section(snapshot_section section) const
+{
+    return reinterpret_cast<const uchar *>(_header) + _header->sections[section];
+}
+
+void GeneratorSnapshot::releaseFile(void *file)
+{
+    delete static_cast<QSharedPointer<QFile> *>(file);
+}
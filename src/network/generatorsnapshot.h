@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GENERATORSNAPSHOT_H
+#define GENERATORSNAPSHOT_H
+
+#include <qnn-global.h>
+
+#include <network/cppnprogram.h>
+#include <network/imagecppngeneratornetwork.h>
+#include <network/imagedirectencodinggeneratornetwork.h>
+#include <image/imageupsampler.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QImage>
+#include <QFile>
+#include <QSharedPointer>
+
+/*!
+ * \brief The GeneratorSnapshot class stores a decoded generator network in a compact binary format and renders it without the gene.
+ *
+ * saveNetworkConfig() writes XML describing the gene, which can not be rendered again without the genetic algorithm.
+ * A snapshot contains exactly what is needed to create the image:
+ *  - ImageCPPNGeneratorNetwork: the activation functions and active connections of the decoded CPPNProgram, size, precision and supersampling.
+ *  - ImageDirectEncodingGeneratorNetwork: the packed RGB pixels encoded by the gene, size and interpolation.
+ *
+ * Snapshots are written by ImageCPPNGeneratorNetwork::saveSnapshot() and ImageDirectEncodingGeneratorNetwork::saveSnapshot().
+ *
+ * The format is designed to be memory mapped and used in place. A snapshot starts with a header of fixed size followed by sections of plain arrays.
+ * All values are stored in the byte order of the machine, snapshots written with another byte order are rejected.
+ * Every section starts at a multiple of 8 bytes and the size of a snapshot is a multiple of 8 bytes, so several snapshots can be concatenated
+ * into one file, mapped once and loaded with load() at the offsets given by size(). Snapshots of another VERSION are rejected.
+ *
+ * Loading does not copy the pixels of a direct encoding, the image of a snapshot with genome scale 1 directly uses the mapped memory.
+ * The connections of a CPPN are copied into a CPPNProgram, which is cheap compared to decoding the gene.
+ */
+
+class QNNSHARED_EXPORT GeneratorSnapshot
+{
+public:
+    /*!
+     * \brief The network stored in a snapshot
+     */
+    enum snapshot_type {
+        SNAPSHOT_INVALID = 0,
+        SNAPSHOT_CPPN = 1,
+        SNAPSHOT_DIRECT_ENCODING = 2
+    };
+
+    /*!
+     * \brief The sections following the header
+     *
+     * A CPPN uses the sections SECTION_FUNCTIONS (qint32 per neuron), SECTION_CONNECTION_COUNTS (qint32 per neuron),
+     * SECTION_CONNECTION_INPUTS (qint32 per connection) and SECTION_CONNECTION_WEIGHTS (double per connection).
+     * A direct encoding only uses SECTION_PIXELS (three bytes per pixel of the gene, no padding between rows).
+     */
+    enum snapshot_section {
+        SECTION_FUNCTIONS = 0,
+        SECTION_CONNECTION_COUNTS = 1,
+        SECTION_CONNECTION_INPUTS = 2,
+        SECTION_CONNECTION_WEIGHTS = 3,
+        SECTION_PIXELS = 0,
+        SECTION_COUNT = 4
+    };
+
+    /*!
+     * \brief Version of the format. Increased whenever the layout changes
+     */
+    static const quint32 VERSION = 1;
+
+    /*!
+     * \brief Written into every header to detect snapshots of another byte order
+     */
+    static const quint32 BYTE_ORDER_MARK = 0x01020304;
+
+    /*!
+     * \brief The header at the start of every snapshot
+     *
+     * All members have their natural alignment, so the header has the same layout on all common platforms.
+     */
+    struct header {
+        /*!
+         * \brief "QNNIGSNP"
+         */
+        char magic[8];
+
+        /*!
+         * \brief BYTE_ORDER_MARK in the byte order of the writer
+         */
+        quint32 byte_order;
+
+        /*!
+         * \brief VERSION of the writer
+         */
+        quint32 version;
+
+        /*!
+         * \brief Network stored in the snapshot (see snapshot_type)
+         */
+        quint32 type;
+
+        /*!
+         * \brief Size of the header in bytes
+         */
+        quint32 header_size;
+
+        /*!
+         * \brief Size of the snapshot including header and sections in bytes. Multiple of 8
+         */
+        quint64 size;
+
+        /*!
+         * \brief Width of the image in pixel
+         */
+        qint32 width;
+
+        /*!
+         * \brief Height of the image in pixel
+         */
+        qint32 height;
+
+        /*!
+         * \brief CPPN: Number of input neurons
+         */
+        qint32 inputs;
+
+        /*!
+         * \brief CPPN: Number of neurons including the three output neurons
+         */
+        qint32 neurons;
+
+        /*!
+         * \brief CPPN: Number of active connections
+         */
+        qint32 connections;
+
+        /*!
+         * \brief CPPN: ImageCPPNGeneratorNetwork::evaluation_precision
+         */
+        qint32 precision;
+
+        /*!
+         * \brief CPPN: ImageCPPNGeneratorNetwork::config::supersampling_samples
+         */
+        qint32 supersampling_samples;
+
+        /*!
+         * \brief CPPN: ImageCPPNGeneratorNetwork::config::supersampling_threshold
+         */
+        qint32 supersampling_threshold;
+
+        /*!
+         * \brief Direct encoding: Width of the grid encoded by the gene
+         */
+        qint32 genome_width;
+
+        /*!
+         * \brief Direct encoding: Height of the grid encoded by the gene
+         */
+        qint32 genome_height;
+
+        /*!
+         * \brief Direct encoding: ImageUpsampler::interpolation_mode
+         */
+        qint32 interpolation;
+
+        /*!
+         * \brief Unused, 0
+         */
+        qint32 reserved;
+
+        /*!
+         * \brief Offset of every section from the start of the snapshot in bytes. 0 if the section is not used
+         */
+        quint64 sections[SECTION_COUNT];
+    };
+
+    /*!
+     * \brief Constructor for an invalid snapshot
+     */
+    GeneratorSnapshot();
+
+    /*!
+     * \brief Maps a snapshot file
+     *
+     * The file stays mapped until close() is called and the snapshot and all images using the mapped memory are destroyed.
+     *
+     * \param path Path of the snapshot file
+     * \return True if the file contains a valid snapshot
+     */
+    bool open(const QString &path);
+
+    /*!
+     * \brief Loads a snapshot from memory
+     *
+     * The memory is not copied. It must stay valid as long as the snapshot and the images created by image() are used.
+     *
+     * \param data Start of the snapshot. Must be aligned to 8 bytes
+     * \param size Available bytes at data. May be bigger than the snapshot
+     * \return True if data contains a valid snapshot
+     */
+    bool load(const uchar *data, qint64 size);
+
+    /*!
+     * \brief Releases the snapshot
+     */
+    void close();
+
+    /*!
+     * \brief Returns whether a valid snapshot is loaded
+     * \return True if a valid snapshot is loaded
+     */
+    bool isValid() const;
+
+    /*!
+     * \brief Returns the network stored in the snapshot
+     * \return Type of the network. SNAPSHOT_INVALID if no valid snapshot is loaded
+     */
+    snapshot_type type() const;
+
+    /*!
+     * \brief Returns the size of the snapshot
+     * \return Size in bytes. A following snapshot in the same file starts at this offset
+     */
+    qint64 size() const;
+
+    /*!
+     * \brief Returns the width of the image
+     * \return Width in pixel
+     */
+    qint32 width() const;
+
+    /*!
+     * \brief Returns the height of the image
+     * \return Height in pixel
+     */
+    qint32 height() const;
+
+    /*!
+     * \brief Returns the decoded network of a CPPN snapshot
+     * \return Decoded network. Empty if the snapshot does not contain a CPPN
+     */
+    const CPPNProgram &program() const;
+
+    /*!
+     * \brief Returns the configuration to render a CPPN snapshot
+     *
+     * width, height, precision, supersampling_samples and supersampling_threshold are set to the stored values, save_image is false.
+     * All other values are the defaults and can be changed before calling ImageCPPNGeneratorNetwork::renderProgram().
+     *
+     * \return Configuration of the stored network
+     */
+    ImageCPPNGeneratorNetwork::config cppnConfig() const;
+
+    /*!
+     * \brief Returns the width of the grid of a direct encoding snapshot
+     * \return Width in pixel
+     */
+    qint32 genomeWidth() const;
+
+    /*!
+     * \brief Returns the height of the grid of a direct encoding snapshot
+     * \return Height in pixel
+     */
+    qint32 genomeHeight() const;
+
+    /*!
+     * \brief Returns the interpolation used to upsample the grid of a direct encoding snapshot
+     * \return Interpolation mode
+     */
+    ImageUpsampler::interpolation_mode interpolation() const;
+
+    /*!
+     * \brief Returns the pixels of a direct encoding snapshot
+     * \return RGB buffer (three bytes per pixel, no padding between rows) of size genomeWidth() * genomeHeight() * 3. NULL for other snapshots
+     */
+    const uchar *pixels() const;
+
+    /*!
+     * \brief Renders the stored network
+     *
+     * A CPPN is evaluated in the calling thread with cppnConfig() at the requested size.
+     * The grid of a direct encoding is upsampled to the requested size with interpolation(). If the grid already has the requested size,
+     * the image has Format_RGB888 and uses the memory of the snapshot without copying.
+     *
+     * \param width Width of the image in pixel. 0 uses the stored width
+     * \param height Height of the image in pixel. 0 uses the stored height
+     * \return Rendered image. Null image if the snapshot is invalid
+     */
+    QImage image(qint32 width = 0, qint32 height = 0) const;
+
+    /*!
+     * \brief Creates the snapshot of a CPPN
+     * \param program Decoded network
+     * \param config Configuration of the network
+     * \return Snapshot
+     */
+    static QByteArray fromCPPN(const CPPNProgram &program, const ImageCPPNGeneratorNetwork::config &config);
+
+    /*!
+     * \brief Creates the snapshot of a direct encoding
+     * \param pixels RGB buffer of the grid encoded by the gene (three bytes per pixel, no padding between rows)
+     * \param genome_width Width of the grid
+     * \param genome_height Height of the grid
+     * \param config Configuration of the network
+     * \return Snapshot
+     */
+    static QByteArray fromDirectEncoding(const uchar *pixels, qint32 genome_width, qint32 genome_height, const ImageDirectEncodingGeneratorNetwork::config &config);
+
+    /*!
+     * \brief Writes a snapshot to a file
+     *
+     * The file is only replaced when the whole snapshot was written (see QSaveFile). On failure an existing file at path is kept unchanged.
+     *
+     * \param snapshot Snapshot created by fromCPPN() or fromDirectEncoding()
+     * \param path Path of the file
+     * \return True on success
+     */
+    static bool write(const QByteArray &snapshot, const QString &path);
+
+private:
+    /*!
+     * \brief Creates an empty snapshot with header
+     * \param type Network stored in the snapshot
+     * \param sizes Size of every section in bytes
+     * \return Snapshot with initialised header, size and section offsets. The sections are filled with 0
+     */
+    static QByteArray createSnapshot(snapshot_type type, const qint64 *sizes);
+
+    /*!
+     * \brief Checks whether a section lies inside the snapshot
+     * \param section Section
+     * \param bytes Size of the section in bytes
+     * \return True if the section is aligned and inside the snapshot
+     */
+    bool checkSection(snapshot_section section, qint64 bytes) const;
+
+    /*!
+     * \brief Returns the start of a section
+     * \param section Section
+     * \return Pointer into the snapshot
+     */
+    const uchar *section(snapshot_section section) const;
+
+    /*!
+     * \brief Cleanup function for images using the memory of a mapped file
+     * \param file Pointer to the QSharedPointer kept alive by the image
+     */
+    static void releaseFile(void *file);
+
+    /*!
+     * \brief The mapped file. NULL if the snapshot was loaded from memory of the caller
+     */
+    QSharedPointer<QFile> _file;
+
+    /*!
+     * \brief The header of the snapshot. NULL if no valid snapshot is loaded
+     */
+    const header *_header;
+
+    /*!
+     * \brief Decoded network of a CPPN snapshot
+     */
+    CPPNProgram _program;
+};
+
+#endif // GENERATORSNAPSHOT_H
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "generatorstatistics.h"
+
+GeneratorStatistics::GeneratorStatistics() :
+    decode_nsecs(0),
+    compile_nsecs(0),
+    evaluation_nsecs(0),
+    image_nsecs(0),
+    save_nsecs(0),
+    images(0),
+    pixels(0),
+    connections(0),
+    bytes_written(0)
+{
+}
+
+void GeneratorStatistics::reset()
+{
+    *this = GeneratorStatistics();
+}
+
+GeneratorStatistics &GeneratorStatistics::operator+=(const GeneratorStatistics &other)
+{
+    decode_nsecs += other.decode_nsecs;
+    compile_nsecs += other.compile_nsecs;
+    evaluation_nsecs += other.evaluation_nsecs;
+    image_nsecs += other.image_nsecs;
+    save_nsecs += other.save_nsecs;
+    images += other.images;
+    pixels += other.pixels;
+    connections += other.connections;
+    bytes_written += other.bytes_written;
+    return *this;
+}
+
+QMap<QString, QVariant> GeneratorStatistics::toMap() const
+{
+    QMap<QString, QVariant> map;
+    map["statistics decode ns"] = decode_nsecs;
+    map["statistics compile ns"] = compile_nsecs;
+    map["statistics evaluation ns"] = evaluation_nsecs;
+    map["statistics image ns"] = image_nsecs;
+    map["statistics save ns"] = save_nsecs;
+    map["statistics images"] = images;
+    map["statistics pixels"] = pixels;
+    map["statistics connections"] = connections;
+    map["statistics bytes written"] = bytes_written;
+    return map;
+}
+
+bool GeneratorStatistics::enabled()
+{
+#ifdef QNN_IMAGE_GENERATORS_STATISTICS
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GENERATORSTATISTICS_H
+#define GENERATORSTATISTICS_H
+
+#include <qnn-global.h>
+
+#include <QMap>
+#include <QString>
+#include <QVariant>
+
+#ifdef QNN_IMAGE_GENERATORS_STATISTICS
+#include <QElapsedTimer>
+
+/*!
+ * \brief Starts a timer for a phase. Does nothing if statistics are disabled
+ */
+#define GENERATOR_STATISTICS_START(timer) QElapsedTimer timer; timer.start()
+
+/*!
+ * \brief Adds the time elapsed since GENERATOR_STATISTICS_START(timer) to a field. Does nothing if statistics are disabled
+ */
+#define GENERATOR_STATISTICS_ADD_TIME(statistics, field, timer) (statistics).field += (timer).nsecsElapsed()
+
+/*!
+ * \brief Adds value to a field. value is not evaluated if statistics are disabled
+ */
+#define GENERATOR_STATISTICS_ADD(statistics, field, value) (statistics).field += (value)
+#else
+#define GENERATOR_STATISTICS_START(timer)
+#define GENERATOR_STATISTICS_ADD_TIME(statistics, field, timer)
+#define GENERATOR_STATISTICS_ADD(statistics, field, value)
+#endif
+
+/*!
+ * \brief The GeneratorStatistics struct contains the time spent in every phase of a generator network and work counters.
+ *
+ * Statistics are only recorded if the library is built with QNN_IMAGE_GENERATORS_STATISTICS defined (qmake CONFIG+=statistics).
+ * Otherwise all recording macros are empty and all values stay 0, so there is no overhead.
+ *
+ * All values are accumulated over every call of the network until they are reset.
+ */
+
+struct QNNSHARED_EXPORT GeneratorStatistics
+{
+    /*!
+     * \brief Time spent decoding the gene in nanoseconds
+     */
+    qint64 decode_nsecs;
+
+    /*!
+     * \brief Time spent compiling or loading native kernels in nanoseconds (see CPPNKernelCompiler)
+     */
+    qint64 compile_nsecs;
+
+    /*!
+     * \brief Time spent evaluating the network and writing the pixels in nanoseconds
+     */
+    qint64 evaluation_nsecs;
+
+    /*!
+     * \brief Time spent creating and filling the QImage outside of the evaluation in nanoseconds
+     */
+    qint64 image_nsecs;
+
+    /*!
+     * \brief Time spent encoding and saving the image in nanoseconds
+     *
+     * For asynchronous saving this only contains the time needed to queue the image.
+     */
+    qint64 save_nsecs;
+
+    /*!
+     * \brief Number of rendered images
+     */
+    qint64 images;
+
+    /*!
+     * \brief Number of pixels evaluated
+     */
+    qint64 pixels;
+
+    /*!
+     * \brief Number of evaluated connections (one multiply-add each)
+     */
+    qint64 connections;
+
+    /*!
+     * \brief Number of bytes written to disk by synchronous saves
+     */
+    qint64 bytes_written;
+
+    /*!
+     * \brief Constructor. All values are 0
+     */
+    GeneratorStatistics();
+
+    /*!
+     * \brief Sets all values to 0
+     */
+    void reset();
+
+    /*!
+     * \brief Adds the values of other
+     * \param other Statistics to add
+     * \return Reference to this
+     */
+    GeneratorStatistics &operator+=(const GeneratorStatistics &other);
+
+    /*!
+     * \brief Returns all values with human readable names, e.g. to save them with the network configuration
+     * \return Map of all values
+     */
+    QMap<QString, QVariant> toMap() const;
+
+    /*!
+     * \brief Returns if the library was built with statistics
+     * \return True if statistics are recorded
+     */
+    static bool enabled();
+};
+
+#endif // GENERATORSTATISTICS_H
@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "imagecppnanimationnetwork.h"
+
+#include <network/lengthchanginggene.h>
+#include <network/commonnetworkfunctions.h>
+#include <network/networktoxml.h>
+#include <network/cppnseparablevalues.h>
+#include <image/imagewriter.h>
+#include <image/ppmstripwriter.h>
+#include <randomhelper.h>
+
+#include <QScopedPointer>
+#include <QMutexLocker>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+
+// GENE ENCODING: function, (activated, weight)^5, (avtivated, weight)^n, (activated, weight)^3
+
+using CommonNetworkFunctions::weight;
+using NetworkToXML::writeConfigStart;
+using NetworkToXML::writeConfigEnd;
+using NetworkToXML::writeConfigNeuron;
+
+ImageCPPNAnimationNetwork::ImageCPPNAnimationNetwork(qint32 len_input, qint32 len_output, config config) :
+    AbstractNeuralNetwork(len_input, len_output),
+    _config(config),
+    _program(),
+    _kernel(NULL),
+    _frames(),
+    _statistics()
+{
+    if(Q_UNLIKELY(_config.max_size < 0))
+    {
+        QNN_FATAL_MSG("Max size must be greater than 0");
+    }
+    if(Q_UNLIKELY(_config.min_size < 0))
+    {
+        QNN_FATAL_MSG("Min size must be greater than 0");
+    }
+    if(Q_UNLIKELY(_config.min_size > _config.max_size))
+    {
+        QNN_FATAL_MSG("Min size must not be greater than max size");
+    }
+    if(Q_UNLIKELY(_config.width <= 0 || _config.height <= 0))
+    {
+        QNN_FATAL_MSG("Width and height must be greater than 0");
+    }
+    if(Q_UNLIKELY(_config.frames <= 0))
+    {
+        QNN_FATAL_MSG("Number of frames must be greater than 0");
+    }
+    if(Q_UNLIKELY(_config.frames_in_flight < 0))
+    {
+        QNN_FATAL_MSG("Frames in flight must not be negative");
+    }
+    if(Q_UNLIKELY(_config.target_fitness != NULL))
+    {
+        QNN_FATAL_MSG("Target fitness is not supported for animations");
+    }
+    if(Q_UNLIKELY(_config.save_image && _config.output == OUTPUT_IMAGE_SEQUENCE && !_config.image_path.contains("%1")))
+    {
+        QNN_FATAL_MSG("Image path must contain %1 for the frame number");
+    }
+}
+
+ImageCPPNAnimationNetwork::~ImageCPPNAnimationNetwork()
+{
+}
+
+GenericGene *ImageCPPNAnimationNetwork::getRandomGene()
+{
+    LengthChangingGene::config config;
+    // 3 Output neurons -> + 3
+    config.min_length = _config.min_size + 3;
+    config.max_length = _config.max_size + 3;
+    qint32 lengh = _config.min_size + RandomHelper::getRandomInt(0, _config.max_size - _config.min_size - 1) + 3;
+    return new LengthChangingGene(lengh, 1 + INPUT_NEURONS*2 + _config.max_size * 2 + 3*2, config);
+}
+
+AbstractNeuralNetwork *ImageCPPNAnimationNetwork::createConfigCopy()
+{
+    return new ImageCPPNAnimationNetwork(_len_input, _len_output, _config);
+}
+
+QList<QImage> ImageCPPNAnimationNetwork::getFrames() const
+{
+    return _frames;
+}
+
+GeneratorStatistics ImageCPPNAnimationNetwork::statistics() const
+{
+    return _statistics;
+}
+
+void ImageCPPNAnimationNetwork::resetStatistics()
+{
+    _statistics.reset();
+}
+
+double ImageCPPNAnimationNetwork::frameTime(qint32 frame, qint32 frames)
+{
+    if(frames <= 1)
+    {
+        return 0.0;
+    }
+    return -1.0 + 2.0 * frame / (frames - 1);
+}
+
+QString ImageCPPNAnimationNetwork::framePath(const QString &path, qint32 frame, qint32 frames)
+{
+    qint32 digits = QString::number(qMax(frames - 1, 0)).size();
+    return path.arg(frame, digits, 10, QChar('0'));
+}
+
+ImageCPPNAnimationNetwork::ImageCPPNAnimationNetwork() :
+    AbstractNeuralNetwork(),
+    _config(),
+    _program(),
+    _kernel(NULL),
+    _frames(),
+    _statistics()
+{
+}
+
+void ImageCPPNAnimationNetwork::_initialise()
+{
+    if(_gene->segments()[0].size() < (1 + INPUT_NEURONS*2 + _config.max_size * 2 + 3*2))
+    {
+        QNN_FATAL_MSG("Segment size do not fit");
+    }
+    GENERATOR_STATISTICS_START(decode_timer);
+    _program.decode(_gene->segments(), INPUT_NEURONS, _config.accuracy);
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, decode_nsecs, decode_timer);
+
+    _kernel = NULL;
+    if(_config.kernel_compiler != NULL)
+    {
+        GENERATOR_STATISTICS_START(compile_timer);
+        _kernel = _config.kernel_compiler->compile(_program, _config.precision == ImageCPPNGeneratorNetwork::PRECISION_FLOAT);
+        GENERATOR_STATISTICS_ADD_TIME(_statistics, compile_nsecs, compile_timer);
+    }
+}
+
+void ImageCPPNAnimationNetwork::_processInput(QList<double> input)
+{
+    Q_UNUSED(input);
+    _frames.clear();
+    QSharedPointer<const CPPNCoordinates> coordinates = CPPNCoordinates::get(_config.width, _config.height);
+    PPMStripWriter video;
+
+    pipeline_state state;
+    state.next_frame = 0;
+    state.finished_frames = 0;
+    state.done.fill(false, _config.frames);
+    state.video = NULL;
+    state.failed = false;
+    state.connections = 0;
+    state.bytes_written = 0;
+    if(!_config.save_image)
+    {
+        state.images.resize(_config.frames);
+    }
+    else if(_config.output == OUTPUT_RAW_VIDEO)
+    {
+        if(!video.open(_config.image_path, _config.width, _config.height * _config.frames, false))
+        {
+            return;
+        }
+        state.video = &video;
+    }
+
+    GENERATOR_STATISTICS_START(evaluation_timer);
+    qint32 threads = _config.frames_in_flight > 0 ? _config.frames_in_flight : QThreadPool::globalInstance()->maxThreadCount();
+    QVector<qint32> workers(qBound(1, threads, _config.frames));
+    QtConcurrent::blockingMap(workers, [this, &state, &coordinates](qint32 &)
+    {
+        renderFrames(state, *coordinates);
+    });
+    if(state.video != NULL)
+    {
+        video.close();
+        state.bytes_written = QFileInfo(_config.image_path).size();
+    }
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, evaluation_nsecs, evaluation_timer);
+
+    for(qint32 frame = 0; frame < state.images.size(); ++frame)
+    {
+        _frames.append(state.images[frame]);
+    }
+    GENERATOR_STATISTICS_ADD(_statistics, images, state.finished_frames);
+    GENERATOR_STATISTICS_ADD(_statistics, pixels, (qint64) state.finished_frames * _config.width * _config.height);
+    GENERATOR_STATISTICS_ADD(_statistics, connections, state.connections);
+    GENERATOR_STATISTICS_ADD(_statistics, bytes_written, state.bytes_written);
+}
+
+void ImageCPPNAnimationNetwork::renderFrames(pipeline_state &state, const CPPNCoordinates &coordinates)
+{
+    const qint64 pixels = (qint64) _config.width * _config.height;
+    // Every worker reuses its scratch memory for all of its frames
+    CPPNRenderContext::scratch scratch;
+
+    forever
+    {
+        qint32 frame;
+        {
+            QMutexLocker locker(&state.mutex);
+            if(state.failed || state.next_frame >= _config.frames)
+            {
+                return;
+            }
+            frame = state.next_frame++;
+        }
+
+        double time = frameTime(frame, _config.frames);
+        QImage image(_config.width, _config.height, QImage::Format_RGB32);
+        QScopedPointer<CPPNSeparableValues> separable;
+        if(_kernel != NULL)
+        {
+            ImageCPPNGeneratorNetwork::renderRowsKernel(_kernel, _config, coordinates, image.bits(), image.bytesPerLine(), 0, _config.height, time, &scratch);
+        }
+        else
+        {
+            if(_config.separable_evaluation)
+            {
+                separable.reset(new CPPNSeparableValues(_program, coordinates, time, _config.precision == ImageCPPNGeneratorNetwork::PRECISION_FLOAT));
+            }
+            ImageCPPNGeneratorNetwork::renderRows(_program, _config, coordinates, image.bits(), image.bytesPerLine(), 0, _config.height, separable.data(), time, &scratch);
+        }
+        qint64 connections = separable.isNull() ? _program.connections().size() * pixels : separable->connectionEvaluations(pixels);
+
+        bool saved = true;
+        qint64 bytes_written = 0;
+        if(!_config.save_image)
+        {
+            state.images[frame] = image;
+        }
+        else if(state.video != NULL)
+        {
+            // The raw video has to be written in order. Only the thread holding the oldest unfinished frame writes
+            {
+                QMutexLocker locker(&state.mutex);
+                while(state.finished_frames != frame && !state.failed)
+                {
+                    state.frame_done.wait(&state.mutex);
+                }
+                if(state.failed)
+                {
+                    return;
+                }
+            }
+            saved = state.video->writeRows(image, _config.height);
+        }
+        else
+        {
+            QString path = framePath(_config.image_path, frame, _config.frames);
+            saved = ImageWriter::writeImage(image, path, _config.image_format, _config.image_quality);
+            bytes_written = QFileInfo(path).size();
+        }
+
+        QMutexLocker locker(&state.mutex);
+        if(!saved)
+        {
+            state.failed = true;
+        }
+        else
+        {
+            state.done[frame] = true;
+            while(state.finished_frames < _config.frames && state.done[state.finished_frames])
+            {
+                ++state.finished_frames;
+            }
+            state.connections += connections;
+            state.bytes_written += bytes_written;
+        }
+        state.frame_done.wakeAll();
+    }
+}
+
+double ImageCPPNAnimationNetwork::_getNeuronOutput(qint32 i)
+{
+    if(Q_UNLIKELY(_frames.isEmpty()))
+    {
+        QNN_WARNING_MSG("No frames are kept in memory");
+        return 0.0;
+    }
+    qint64 pixel = i / 3;
+    qint64 frame_pixels = (qint64) _config.width * (qint64) _config.height;
+    if(Q_UNLIKELY(i < 0 || pixel >= frame_pixels * _frames.size()))
+    {
+        QNN_WARNING_MSG(QString("Output %1 is outside of the animation").arg(i));
+        return 0.0;
+    }
+    const QImage &frame = _frames[pixel / frame_pixels];
+    pixel %= frame_pixels;
+    QRgb rgb = frame.pixel(pixel % _config.width, pixel / _config.width);
+    switch(i % 3)
+    {
+    case 0:
+        return qRed(rgb) / 255.0;
+    case 1:
+        return qGreen(rgb) / 255.0;
+    default:
+        return qBlue(rgb) / 255.0;
+    }
+}
+
+bool ImageCPPNAnimationNetwork::_saveNetworkConfig(QXmlStreamWriter *stream)
+{
+    QMap<QString, QVariant> config_network;
+    config_network["width"] = _config.width;
+    config_network["height"] = _config.height;
+    config_network["frames"] = _config.frames;
+    config_network["min hidden neurons"] = _config.min_size;
+    config_network["max hidden neurons"] = _config.max_size;
+    if(_config.save_statistics && GeneratorStatistics::enabled())
+    {
+        QMap<QString, QVariant> statistics = _statistics.toMap();
+        foreach(QString key, statistics.keys())
+        {
+            config_network[key] = statistics[key];
+        }
+    }
+    writeConfigStart("ImageCPPNAnimationNetwork", config_network, stream);
+
+    for(qint32 neuron = 0; neuron < _gene->segments().size(); ++neuron)
+    {
+        QMap<QString, QVariant> config_neuron;
+        QMap<qint32, double> connection_neuron;
+
+        config_neuron["function"] = CPPNProgram::functionName(CPPNProgram::functionFromGene(_gene->segments()[neuron][0]));
+
+        for(qint32 input = 0; input < neuron + INPUT_NEURONS; ++input)
+        {
+            if(_gene->segments()[neuron][1 + (2 * input)] % 2)
+            {
+                if(input < INPUT_NEURONS)
+                {
+                    config_neuron[QString("input %1").arg(input)] = weight(_gene->segments()[neuron][1 + (2 * input) + 1], 1);
+                }
+                else
+                {
+                    connection_neuron[input - INPUT_NEURONS] = weight(_gene->segments()[neuron][1 + (2 * input) + 1], 1);
+                }
+            }
+        }
+
+        // Neurons are numbered like in ImageCPPNGeneratorNetwork, shifted by the number of input neurons
+        writeConfigNeuron(neuron - INPUT_NEURONS, config_neuron, connection_neuron, stream);
+    }
+    writeConfigEnd(stream);
+    return true;
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IMAGECPPNANIMATIONNETWORK_H
+#define IMAGECPPNANIMATIONNETWORK_H
+
+#include <qnn-global.h>
+
+#include <network/abstractneuralnetwork.h>
+#include <network/imagecppngeneratornetwork.h>
+#include <network/cppnprogram.h>
+#include <network/cppncoordinates.h>
+#include <network/generatorstatistics.h>
+
+#include <QImage>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+
+class PPMStripWriter;
+
+/*!
+ * \brief The ImageCPPNAnimationNetwork class creates an animation out of a CPPN gene.
+ *
+ * The network works like ImageCPPNGeneratorNetwork, but has the time as additional input (see CPPNProgram::TIME_INPUT).
+ * The gene is decoded once and all frames are rendered from the same program. The time runs from -1 in the first frame to 1 in the last frame.
+ *
+ * The frames are rendered in parallel on the global QThreadPool, every frame by one thread. Finished frames are written directly by the thread
+ * which rendered them, either as numbered image sequence or as single raw video stream. Every thread keeps at most one frame,
+ * so no more than frames_in_flight frames are in memory at the same time.
+ */
+
+class QNNSHARED_EXPORT ImageCPPNAnimationNetwork : public AbstractNeuralNetwork
+{
+public:
+    /*!
+     * \brief Number of input neurons (bias, x, y, distance to center, time)
+     */
+    static const qint32 INPUT_NEURONS = 5;
+
+    /*!
+     * \brief How the frames are saved
+     */
+    enum animation_output {
+        /*!
+         * \brief Every frame is saved as image. image_path must contain "%1", which is replaced by the frame number
+         */
+        OUTPUT_IMAGE_SEQUENCE,
+
+        /*!
+         * \brief All frames are appended to the file at image_path as raw RGB data (3 byte per pixel, no header)
+         *
+         * The stream can be read e.g. with "ffmpeg -f rawvideo -pixel_format rgb24 -video_size <width>x<height> -i <image_path>".
+         */
+        OUTPUT_RAW_VIDEO
+    };
+
+    /*!
+     * \brief This struct contains all configuration option of the ImageCPPNAnimationNetwork
+     *
+     * The options of ImageCPPNGeneratorNetwork::config apply to every frame with the following exceptions:
+     * parallel_rendering, band_height, asynchronous_save, strip_height, activation_cache, render_cache, supersampling_samples, supersampling_threshold
+     * and fitness_threshold are ignored. The animation has no fitness evaluation, so target_fitness must be NULL.
+     * image_format and image_quality are only used for OUTPUT_IMAGE_SEQUENCE.
+     * The kernel of kernel_compiler is compiled once and used for all frames, so the compile time is shared by all frames.
+     */
+    struct config : public ImageCPPNGeneratorNetwork::config {
+
+        /*!
+         * \brief Number of frames
+         *
+         * Must be greater than zero.
+         */
+        qint32 frames;
+
+        /*!
+         * \brief How the frames are saved if save_image is true
+         *
+         * If save_image is false, all frames are kept in memory and can be accessed through getFrames().
+         */
+        animation_output output;
+
+        /*!
+         * \brief Maximum number of frames rendered at the same time. 0 uses the maximum thread count of the global QThreadPool
+         *
+         * Must not be negative.
+         */
+        qint32 frames_in_flight;
+
+        /*!
+         * \brief Constructor for standard values
+         */
+        config() :
+            ImageCPPNGeneratorNetwork::config(),
+            frames(30),
+            output(OUTPUT_IMAGE_SEQUENCE),
+            frames_in_flight(0)
+        {
+            image_path = "./qnn-image-generators-CPPN-%1.png";
+        }
+    };
+
+    /*!
+     * \brief Constructor
+     * \param len_input Length of the input
+     * \param len_output Length of the output
+     * \param config Configuration of the ImageCPPNAnimationNetwork
+     */
+    ImageCPPNAnimationNetwork(qint32 len_input, qint32 len_output, config config = config());
+
+    /*!
+     * \brief Destructor
+     */
+    ~ImageCPPNAnimationNetwork();
+
+    /*!
+     * \brief Returns a random gene which may be used with the current network configuration
+     * \return Random gene. The caller must delete the gene
+     */
+    GenericGene *getRandomGene();
+
+    /*!
+     * \brief Creates a uninitialised copy of the network
+     * \return Copy of the network. The caller must delete the gene
+     */
+    AbstractNeuralNetwork *createConfigCopy();
+
+    /*!
+     * \brief Returns the frames generated by the last call of processInput(QList<double> input)
+     * \return Generated frames. Empty if save_image is true or no animation was generated yet
+     */
+    QList<QImage> getFrames() const;
+
+    /*!
+     * \brief Returns the statistics recorded by the network
+     *
+     * Because rendering and saving overlap, evaluation_nsecs contains the time of the whole animation including saving.
+     *
+     * \return Statistics accumulated since the construction of the network or the last call of resetStatistics()
+     */
+    GeneratorStatistics statistics() const;
+
+    /*!
+     * \brief Resets all recorded statistics to 0
+     */
+    void resetStatistics();
+
+    /*!
+     * \brief Returns the value of the time input of a frame
+     * \param frame Number of the frame
+     * \param frames Number of frames
+     * \return Time between -1 and 1
+     */
+    static double frameTime(qint32 frame, qint32 frames);
+
+    /*!
+     * \brief Returns the path of a frame of an image sequence
+     * \param path Path containing "%1"
+     * \param frame Number of the frame
+     * \param frames Number of frames. The frame number is padded with zeros to the number of digits of the last frame
+     * \return Path of the frame
+     */
+    static QString framePath(const QString &path, qint32 frame, qint32 frames);
+
+protected:
+    /*!
+     * \brief Empty constructor
+     *
+     * This constructor may be useful for subclasses
+     */
+    ImageCPPNAnimationNetwork();
+
+    /*!
+     * \brief Overwritten function to initialise the network.
+     *
+     * The gene is decoded once into a CPPNProgram which is used for all frames.
+     */
+    void _initialise();
+
+    /*!
+     * \brief Overwritten method to process input
+     *
+     * Renders and saves all frames. The input has no influence on the animation.
+     *
+     * \param input Input to process
+     */
+    void _processInput(QList<double> input);
+
+    /*!
+     * \brief Overwritten function to get output
+     *
+     * The output of this network are the channels of the frames kept in memory (see getFrames()).
+     * Output i is channel (i % 3) (red, green, blue) of pixel (i / 3), pixels are counted row by row and frame by frame.
+     *
+     * \param i Number of neuron (0 <= i < len_output)
+     * \return Value of the channel between 0 and 1
+     */
+    double _getNeuronOutput(qint32 i);
+
+    /*!
+     * \brief Overwritten function to save network config
+     * \param stream QXmlStreamWriter to write on
+     * \return True if successful
+     */
+    bool _saveNetworkConfig(QXmlStreamWriter *stream);
+
+    /*!
+     * \brief State shared by the threads rendering an animation
+     */
+    struct pipeline_state {
+        QMutex mutex;
+
+        /*!
+         * \brief Signaled whenever a frame is finished
+         */
+        QWaitCondition frame_done;
+
+        /*!
+         * \brief The next frame which is not claimed by a thread
+         */
+        qint32 next_frame;
+
+        /*!
+         * \brief All frames before this frame are finished
+         */
+        qint32 finished_frames;
+
+        /*!
+         * \brief Finished state of every frame
+         */
+        QVector<bool> done;
+
+        /*!
+         * \brief The frames if they are kept in memory
+         */
+        QVector<QImage> images;
+
+        /*!
+         * \brief Raw video stream. NULL for image sequences
+         */
+        PPMStripWriter *video;
+
+        /*!
+         * \brief True if saving a frame failed. No further frames are rendered
+         */
+        bool failed;
+
+        qint64 connections;
+        qint64 bytes_written;
+    };
+
+    /*!
+     * \brief Claims, renders and saves frames until all frames are claimed. Executed by every rendering thread
+     * \param state State of the animation
+     * \param coordinates Coordinate inputs for the size of the frames
+     */
+    void renderFrames(pipeline_state &state, const CPPNCoordinates &coordinates);
+
+private:
+    config _config;
+
+    /*!
+     * \brief The decoded gene. Created in _initialise()
+     */
+    CPPNProgram _program;
+
+    /*!
+     * \brief Native kernel of the current gene. NULL if no kernel_compiler is set or the gene could not be compiled
+     */
+    CPPNKernelCompiler::row_kernel _kernel;
+
+    /*!
+     * \brief The frames generated by the last call of _processInput(QList<double> input) if save_image is false
+     */
+    QList<QImage> _frames;
+
+    /*!
+     * \brief Statistics recorded by the network
+     */
+    GeneratorStatistics _statistics;
+};
+
+#endif // IMAGECPPNANIMATIONNETWORK_H
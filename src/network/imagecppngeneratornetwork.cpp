@@ -22,14 +22,23 @@
 #include <network/lengthchanginggene.h>
 #include <network/commonnetworkfunctions.h>
 #include <network/networktoxml.h>
+#include <network/generatorsnapshot.h>
+#include <image/imagewriter.h>
+#include <image/ppmstripwriter.h>
 #include <randomhelper.h>
 
+#include <algorithm>
+#include <limits>
 #include <QtCore/qmath.h>
 #include <QImage>
+#include <QScopedPointer>
+#include <QFileInfo>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QAtomicInteger>
+#include <QThreadPool>
 
 // GENE ENCODING: function, (activated, weight)^4, (avtivated, weight)^n, (activated, weight)^3
 
-using CommonNetworkFunctions::sigmoid;
 using CommonNetworkFunctions::weight;
 using CommonNetworkFunctions::floatFromGeneInput;
 using NetworkToXML::writeConfigStart;
@@ -38,7 +47,16 @@ using NetworkToXML::writeConfigNeuron;
 
 ImageCPPNGeneratorNetwork::ImageCPPNGeneratorNetwork(qint32 len_input, qint32 len_output, config config) :
     AbstractNeuralNetwork(len_input, len_output),
-    _config(config)
+    _config(config),
+    _program(),
+    _image(),
+    _render_key(0),
+    _kernel(NULL),
+    _context(),
+    _supersampling_evaluations(0),
+    _fitness(0.0),
+    _fitness_exceeded(false),
+    _statistics()
 {
     if(Q_UNLIKELY(_config.max_size < 0))
     {
@@ -52,6 +70,30 @@ ImageCPPNGeneratorNetwork::ImageCPPNGeneratorNetwork(qint32 len_input, qint32 le
     {
         QNN_FATAL_MSG("Min size must not be greater than max size");
     }
+    if(Q_UNLIKELY(_config.band_height <= 0))
+    {
+        QNN_FATAL_MSG("Band height must be greater than 0");
+    }
+    if(Q_UNLIKELY(_config.strip_height < 0))
+    {
+        QNN_FATAL_MSG("Strip height must not be negative");
+    }
+    if(Q_UNLIKELY(_config.supersampling_samples <= 0))
+    {
+        QNN_FATAL_MSG("Supersampling samples must be greater than 0");
+    }
+    if(Q_UNLIKELY(_config.supersampling_threshold < 0))
+    {
+        QNN_FATAL_MSG("Supersampling threshold must not be negative");
+    }
+    if(Q_UNLIKELY(_config.activation_cache != NULL && (qint64) _config.width * (qint64) _config.height > std::numeric_limits<qint32>::max()))
+    {
+        QNN_FATAL_MSG("Image is to big to be used with an activation cache");
+    }
+    if(Q_UNLIKELY(_config.target_fitness != NULL && (_config.target_fitness->width() != _config.width || _config.target_fitness->height() != _config.height)))
+    {
+        QNN_FATAL_MSG("Size of the target image does not fit");
+    }
 }
 
 ImageCPPNGeneratorNetwork::~ImageCPPNGeneratorNetwork()
@@ -65,7 +107,7 @@ GenericGene *ImageCPPNGeneratorNetwork::getRandomGene()
     config.min_length = _config.min_size + 3;
     config.max_length = _config.max_size + 3;
     qint32 lengh = _config.min_size + RandomHelper::getRandomInt(0, _config.max_size - _config.min_size - 1) + 3;
-    return new LengthChangingGene(lengh, 1 + 4*2 + _config.max_size * 2 + 3*2, config);
+    return new LengthChangingGene(lengh, 1 + INPUT_NEURONS*2 + _config.max_size * 2 + 3*2, config);
 }
 
 AbstractNeuralNetwork *ImageCPPNGeneratorNetwork::createConfigCopy()
@@ -73,70 +115,490 @@ AbstractNeuralNetwork *ImageCPPNGeneratorNetwork::createConfigCopy()
     return new ImageCPPNGeneratorNetwork(_len_input, _len_output, _config);
 }
 
+QList<QImage> ImageCPPNGeneratorNetwork::renderPopulation(QList<GenericGene *> genes, config config)
+{
+    if(Q_UNLIKELY(config.band_height <= 0))
+    {
+        QNN_FATAL_MSG("Band height must be greater than 0");
+    }
+
+    QSharedPointer<const CPPNCoordinates> coordinates = CPPNCoordinates::get(config.width, config.height);
+    QVector<CPPNProgram> programs(genes.size());
+    QVector< QSharedPointer<CPPNSeparableValues> > separable(genes.size());
+    QList<QImage> images;
+    QVector<population_job> jobs;
+    QVector<bool> rendered(genes.size(), false);
+
+    for(qint32 i = 0; i < genes.size(); ++i)
+    {
+        if(Q_UNLIKELY(genes[i]->segments()[0].size() < (1 + INPUT_NEURONS*2 + config.max_size * 2 + 3*2)))
+        {
+            QNN_FATAL_MSG("Segment size do not fit");
+        }
+        programs[i].decode(genes[i]->segments(), INPUT_NEURONS, config.accuracy);
+        if(config.render_cache != NULL)
+        {
+            images.append(config.render_cache->findImage(renderKey(programs[i], config)));
+            if(!images[i].isNull())
+            {
+                continue;
+            }
+            images.removeLast();
+        }
+        if(config.separable_evaluation)
+        {
+            separable[i] = QSharedPointer<CPPNSeparableValues>(new CPPNSeparableValues(programs[i], *coordinates, 0.0, config.precision == PRECISION_FLOAT));
+        }
+        images.append(QImage(config.width, config.height, QImage::Format_RGB32));
+        rendered[i] = true;
+
+        population_job job;
+        job.program = &programs[i];
+        job.separable = separable[i].data();
+        job.bits = images[i].bits();
+        job.bytes_per_line = images[i].bytesPerLine();
+        for(qint32 row = 0; row < config.height; row += config.band_height)
+        {
+            job.first_row = row;
+            jobs.append(job);
+        }
+    }
+
+    QtConcurrent::blockingMap(jobs, [&config, &coordinates](population_job &job)
+    {
+        renderRows(*job.program, config, *coordinates, job.bits + (qint64) job.first_row * job.bytes_per_line, job.bytes_per_line, job.first_row, qMin(job.first_row + config.band_height, config.height), job.separable);
+    });
+
+    for(qint32 i = 0; i < genes.size(); ++i)
+    {
+        if(rendered[i])
+        {
+            supersample(programs[i], config, images[i].bits(), images[i].bytesPerLine());
+        }
+    }
+
+    if(config.render_cache != NULL)
+    {
+        for(qint32 i = 0; i < genes.size(); ++i)
+        {
+            config.render_cache->insertImage(renderKey(programs[i], config), images[i]);
+        }
+    }
+
+    return images;
+}
+
+QImage ImageCPPNGeneratorNetwork::renderProgram(const CPPNProgram &program, config config)
+{
+    if(Q_UNLIKELY(config.band_height <= 0))
+    {
+        QNN_FATAL_MSG("Band height must be greater than 0");
+    }
+    if(Q_UNLIKELY(program.inputCount() != INPUT_NEURONS))
+    {
+        QNN_WARNING_MSG("Program does not fit the network");
+        return QImage();
+    }
+
+    QSharedPointer<const CPPNCoordinates> coordinates = CPPNCoordinates::get(config.width, config.height);
+    QImage image(config.width, config.height, QImage::Format_RGB32);
+    uchar *bits = image.bits();
+    qint32 bytes_per_line = image.bytesPerLine();
+
+    CPPNKernelCompiler::row_kernel kernel = NULL;
+    if(config.kernel_compiler != NULL)
+    {
+        kernel = config.kernel_compiler->compile(program, config.precision == PRECISION_FLOAT);
+    }
+    QScopedPointer<CPPNSeparableValues> separable;
+    if(config.separable_evaluation && kernel == NULL)
+    {
+        separable.reset(new CPPNSeparableValues(program, *coordinates, 0.0, config.precision == PRECISION_FLOAT));
+    }
+
+    auto render_rows = [&program, &config, &coordinates, kernel, &separable, bits, bytes_per_line](qint32 first_row, qint32 last_row)
+    {
+        if(kernel != NULL)
+        {
+            renderRowsKernel(kernel, config, *coordinates, bits + (qint64) first_row * bytes_per_line, bytes_per_line, first_row, last_row);
+        }
+        else
+        {
+            renderRows(program, config, *coordinates, bits + (qint64) first_row * bytes_per_line, bytes_per_line, first_row, last_row, separable.data());
+        }
+    };
+
+    if(config.parallel_rendering)
+    {
+        QVector<qint32> bands;
+        for(qint32 row = 0; row < config.height; row += config.band_height)
+        {
+            bands.append(row);
+        }
+        QtConcurrent::blockingMap(bands, [&render_rows, &config](qint32 &first_row)
+        {
+            render_rows(first_row, qMin(first_row + config.band_height, config.height));
+        });
+    }
+    else
+    {
+        render_rows(0, config.height);
+    }
+    supersample(program, config, bits, bytes_per_line);
+    return image;
+}
+
+bool ImageCPPNGeneratorNetwork::saveSnapshot(const QString &path) const
+{
+    if(Q_UNLIKELY(_gene == NULL))
+    {
+        QNN_WARNING_MSG("Network is not initialised");
+        return false;
+    }
+    return GeneratorSnapshot::write(GeneratorSnapshot::fromCPPN(_program, _config), path);
+}
+
+QImage ImageCPPNGeneratorNetwork::getImage() const
+{
+    return _image;
+}
+
+quint64 ImageCPPNGeneratorNetwork::renderKey() const
+{
+    return _render_key;
+}
+
+qint64 ImageCPPNGeneratorNetwork::supersamplingEvaluations() const
+{
+    return _supersampling_evaluations;
+}
+
+double ImageCPPNGeneratorNetwork::fitness() const
+{
+    return _fitness;
+}
+
+bool ImageCPPNGeneratorNetwork::fitnessThresholdExceeded() const
+{
+    return _fitness_exceeded;
+}
+
+GeneratorStatistics ImageCPPNGeneratorNetwork::statistics() const
+{
+    return _statistics;
+}
+
+void ImageCPPNGeneratorNetwork::resetStatistics()
+{
+    _statistics.reset();
+}
+
 ImageCPPNGeneratorNetwork::ImageCPPNGeneratorNetwork() :
     AbstractNeuralNetwork(),
-    _config()
+    _config(),
+    _program(),
+    _image(),
+    _render_key(0),
+    _kernel(NULL),
+    _context(),
+    _supersampling_evaluations(0),
+    _fitness(0.0),
+    _fitness_exceeded(false),
+    _statistics()
 {
 }
 
 void ImageCPPNGeneratorNetwork::_initialise()
 {
-    if(_gene->segments()[0].size() < (1 + 4*2 + _config.max_size * 2 + 3*2))
+    if(_gene->segments()[0].size() < (1 + INPUT_NEURONS*2 + _config.max_size * 2 + 3*2))
     {
         QNN_FATAL_MSG("Segment size do not fit");
     }
+    GENERATOR_STATISTICS_START(decode_timer);
+    _program.decode(_gene->segments(), INPUT_NEURONS, _config.accuracy);
+    _render_key = renderKey(_program, _config);
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, decode_nsecs, decode_timer);
+
+    // The scratch memory is sized for the biggest gene of the configuration, so genes of later initialisations fit as well
+    qint32 workers = 1;
+    if(_config.parallel_rendering)
+    {
+        workers = qBound(1, QThreadPool::globalInstance()->maxThreadCount(), (_config.height + _config.band_height - 1) / _config.band_height);
+    }
+    _context.prepare(_config.width, _config.height, qMax(_program.networkSize(), INPUT_NEURONS + _config.max_size + 3), _config.band_height, workers);
+
+    _kernel = NULL;
+    if(_config.kernel_compiler != NULL && _config.activation_cache == NULL)
+    {
+        GENERATOR_STATISTICS_START(compile_timer);
+        _kernel = _config.kernel_compiler->compile(_program, _config.precision == PRECISION_FLOAT);
+        GENERATOR_STATISTICS_ADD_TIME(_statistics, compile_nsecs, compile_timer);
+    }
 }
 
 void ImageCPPNGeneratorNetwork::_processInput(QList<double> input)
 {
     Q_UNUSED(input);
-    QImage image(_config.width, _config.height, QImage::Format_RGB32);
-    qint32 x_center = _config.width / 2;
-    qint32 y_center = _config.height / 2;
-    double max_distance = qSqrt(qPow(_config.width, 2) + qPow(_config.height, 2))/2;
-    qint32 neurons = 4 + _gene->segments().size();
+    _supersampling_evaluations = 0;
+    if(_config.target_fitness != NULL)
+    {
+        renderFitness();
+        return;
+    }
+    if(_config.strip_height > 0 && _config.save_image)
+    {
+        renderStrips();
+        return;
+    }
 
-    for(qint32 width = 0; width < _config.width; ++width)
+    QImage cached;
+    if(_config.render_cache != NULL)
+    {
+        cached = _config.render_cache->findImage(_render_key);
+    }
+    if(!cached.isNull())
     {
-        for(qint32 height = 0; height < _config.height; ++height)
+        _image = cached;
+    }
+    else
+    {
+        renderImage();
+        if(_config.render_cache != NULL)
         {
-            double distance_to_center = qSqrt(qPow(width - x_center, 2) + qPow(height - y_center, 2)) / max_distance;
-            double network[neurons];
-            network[0] = 1.0;
-            network[1] = (qreal) width / (qreal) _config.width;
-            network[2] = (qreal) height / (qreal) _config.height;
-            network[3] = distance_to_center;
-            for(qint32 neuron = 0; neuron < _gene->segments().size(); ++neuron)
+            _config.render_cache->insertImage(_render_key, _image);
+        }
+    }
+    GENERATOR_STATISTICS_ADD(_statistics, images, 1);
+
+    if(_config.save_image)
+    {
+        GENERATOR_STATISTICS_START(save_timer);
+        if(_config.asynchronous_save)
+        {
+            ImageWriter::globalInstance()->write(_image, _config.image_path, _config.image_format, _config.image_quality);
+        }
+        else
+        {
+            ImageWriter::writeImage(_image, _config.image_path, _config.image_format, _config.image_quality);
+            GENERATOR_STATISTICS_ADD(_statistics, bytes_written, QFileInfo(_config.image_path).size());
+        }
+        GENERATOR_STATISTICS_ADD_TIME(_statistics, save_nsecs, save_timer);
+    }
+}
+
+void ImageCPPNGeneratorNetwork::renderImage()
+{
+    GENERATOR_STATISTICS_START(image_timer);
+    CPPNRenderContext::prepareImage(_image, _config.width, _config.height);
+    const CPPNCoordinates &coordinates = _context.coordinates();
+    uchar *bits = _image.bits();
+    qint32 bytes_per_line = _image.bytesPerLine();
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, image_nsecs, image_timer);
+
+    GENERATOR_STATISTICS_START(evaluation_timer);
+    const CPPNSeparableValues *separable = NULL;
+    if(_config.separable_evaluation && _config.activation_cache == NULL && _kernel == NULL)
+    {
+        separable = _context.separable(_program, _config.precision == PRECISION_FLOAT);
+    }
+
+    if(_config.activation_cache != NULL)
+    {
+        qint64 connections = renderPlanes(_program, _config, coordinates, bits, bytes_per_line);
+        Q_UNUSED(connections);
+        GENERATOR_STATISTICS_ADD(_statistics, connections, connections);
+    }
+    else
+    {
+        renderImageRows(bits, bytes_per_line, 0, _config.height, separable);
+    }
+    if(_config.activation_cache == NULL)
+    {
+        GENERATOR_STATISTICS_ADD(_statistics, connections, separable == NULL ? _program.connections().size() * (qint64) _config.width * _config.height : separable->connectionEvaluations((qint64) _config.width * _config.height));
+    }
+    _supersampling_evaluations = supersample(_program, _config, bits, bytes_per_line);
+    GENERATOR_STATISTICS_ADD(_statistics, connections, _program.connections().size() * _supersampling_evaluations);
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, evaluation_nsecs, evaluation_timer);
+    GENERATOR_STATISTICS_ADD(_statistics, pixels, (qint64) _config.width * _config.height);
+}
+
+void ImageCPPNGeneratorNetwork::renderImageRows(uchar *bits, qint32 bytes_per_line, qint32 first_row, qint32 last_row, const CPPNSeparableValues *separable)
+{
+    const CPPNCoordinates &coordinates = _context.coordinates();
+    auto render_rows = [this, &coordinates, bits, bytes_per_line, first_row, separable](qint32 band_row, qint32 band_last_row, CPPNRenderContext::scratch &scratch)
+    {
+        uchar *band_bits = bits + (qint64) (band_row - first_row) * bytes_per_line;
+        if(_kernel != NULL)
+        {
+            renderRowsKernel(_kernel, _config, coordinates, band_bits, bytes_per_line, band_row, band_last_row, 0.0, &scratch);
+        }
+        else
+        {
+            renderRows(_program, _config, coordinates, band_bits, bytes_per_line, band_row, band_last_row, separable, 0.0, &scratch);
+        }
+    };
+
+    if(_config.parallel_rendering && _context.workerCount() > 1)
+    {
+        // Every worker uses its own scratch slot and takes the next band until all bands are rendered
+        qint32 band_height = _config.band_height;
+        qint32 bands = (last_row - first_row + band_height - 1) / band_height;
+        QAtomicInt next_band(0);
+        QtConcurrent::blockingMap(_context.workers(), [this, &render_rows, &next_band, bands, band_height, first_row, last_row](qint32 &worker)
+        {
+            CPPNRenderContext::scratch &scratch = _context.slot(worker);
+            for(qint32 band = next_band.fetchAndAddRelaxed(1); band < bands; band = next_band.fetchAndAddRelaxed(1))
             {
-                double value = 0.0;
-                for(qint32 input = 0; input < neuron + 4; ++input)
-                {
-                    if(weight(_gene->segments()[neuron][1 + (2 * input)], 1) > 0)
-                    {
-                        value += network[input] * weight(_gene->segments()[neuron][1 + (2 * input) + 1], 1);
-                    }
-                }
-                network[4 + neuron] = applyFunction(value, _gene->segments()[neuron][0]);
+                qint32 band_row = first_row + band * band_height;
+                render_rows(band_row, qMin(band_row + band_height, last_row), scratch);
             }
-            qint32 r = qFloor(qBound(0.0, network[neurons - 3] * 255, 255.0));
-            qint32 g = qFloor(qBound(0.0, network[neurons - 2] * 255, 255.0));
-            qint32 b = qFloor(qBound(0.0, network[neurons - 1] * 255, 255.0));
-            QRgb pixel = qRgb(r, g, b);
-            image.setPixel(width, height, pixel);
+        });
+    }
+    else
+    {
+        render_rows(first_row, last_row, _context.slot(0));
+    }
+}
+
+void ImageCPPNGeneratorNetwork::renderStrips()
+{
+    _image = QImage();
+    qint32 strip_height = qMin(_config.strip_height, _config.height);
+    QImage strip(_config.width, strip_height, QImage::Format_RGB32);
+    uchar *bits = strip.bits();
+    qint32 bytes_per_line = strip.bytesPerLine();
+    PPMStripWriter writer;
+
+    if(!writer.open(_config.image_path, _config.width, _config.height))
+    {
+        return;
+    }
+
+    GENERATOR_STATISTICS_START(separable_timer);
+    const CPPNSeparableValues *separable = NULL;
+    if(_config.separable_evaluation && _kernel == NULL)
+    {
+        separable = _context.separable(_program, _config.precision == PRECISION_FLOAT);
+    }
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, evaluation_nsecs, separable_timer);
+
+    for(qint32 first_row = 0; first_row < _config.height; first_row += strip_height)
+    {
+        qint32 last_row = qMin(first_row + strip_height, _config.height);
+
+        GENERATOR_STATISTICS_START(evaluation_timer);
+        renderImageRows(bits, bytes_per_line, first_row, last_row, separable);
+        GENERATOR_STATISTICS_ADD_TIME(_statistics, evaluation_nsecs, evaluation_timer);
+
+        GENERATOR_STATISTICS_START(save_timer);
+        bool written = writer.writeRows(strip, last_row - first_row);
+        GENERATOR_STATISTICS_ADD_TIME(_statistics, save_nsecs, save_timer);
+        if(!written)
+        {
+            break;
         }
     }
+    writer.close();
+
+    GENERATOR_STATISTICS_ADD(_statistics, connections, separable == NULL ? _program.connections().size() * (qint64) _config.width * _config.height : separable->connectionEvaluations((qint64) _config.width * _config.height));
+    GENERATOR_STATISTICS_ADD(_statistics, pixels, (qint64) _config.width * _config.height);
+    GENERATOR_STATISTICS_ADD(_statistics, images, 1);
+    GENERATOR_STATISTICS_ADD(_statistics, bytes_written, QFileInfo(_config.image_path).size());
+}
+
+void ImageCPPNGeneratorNetwork::renderFitness()
+{
+    _image = QImage();
+    const ImageTargetFitness *target = _config.target_fitness;
+    qint64 limit = target->errorLimit(_config.fitness_threshold);
+    const CPPNCoordinates &coordinates = _context.coordinates();
+
+    GENERATOR_STATISTICS_START(evaluation_timer);
+    const CPPNSeparableValues *separable = NULL;
+    if(_config.separable_evaluation && _kernel == NULL)
+    {
+        separable = _context.separable(_program, _config.precision == PRECISION_FLOAT);
+    }
 
-    if(!image.save(_config.image_path))
+    qint32 band_height = _config.band_height;
+    qint32 bands = (_config.height + band_height - 1) / band_height;
+    QAtomicInteger<qint64> error(0);
+    QAtomicInteger<qint64> rendered_pixels(0);
+    auto render_band = [this, target, limit, &coordinates, separable, band_height, &error, &rendered_pixels](qint32 band, CPPNRenderContext::scratch &scratch)
+    {
+        // Bands are skipped as soon as the threshold is exceeded
+        if(error.load() > limit)
+        {
+            return;
+        }
+        qint32 first_row = band * band_height;
+        qint32 last_row = qMin(first_row + band_height, _config.height);
+        qint32 pixels = _config.width * (last_row - first_row);
+        QRgb *band_pixels = scratch.pixels(pixels);
+        uchar *bits = reinterpret_cast<uchar *>(band_pixels);
+        qint32 bytes_per_line = _config.width * sizeof(QRgb);
+        if(_kernel != NULL)
+        {
+            renderRowsKernel(_kernel, _config, coordinates, bits, bytes_per_line, first_row, last_row, 0.0, &scratch);
+        }
+        else
+        {
+            renderRows(_program, _config, coordinates, bits, bytes_per_line, first_row, last_row, separable, 0.0, &scratch);
+        }
+        error.fetchAndAddRelaxed(target->error(band_pixels, first_row, last_row - first_row));
+        rendered_pixels.fetchAndAddRelaxed(pixels);
+    };
+
+    if(_config.parallel_rendering && _context.workerCount() > 1)
+    {
+        QAtomicInt next_band(0);
+        QtConcurrent::blockingMap(_context.workers(), [this, &render_band, &next_band, bands](qint32 &worker)
+        {
+            CPPNRenderContext::scratch &scratch = _context.slot(worker);
+            for(qint32 band = next_band.fetchAndAddRelaxed(1); band < bands; band = next_band.fetchAndAddRelaxed(1))
+            {
+                render_band(band, scratch);
+            }
+        });
+    }
+    else
     {
-        QNN_WARNING_MSG(QString("Could not save image to %1").arg(_config.image_path));
+        for(qint32 band = 0; band < bands && error.load() <= limit; ++band)
+        {
+            render_band(band, _context.slot(0));
+        }
     }
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, evaluation_nsecs, evaluation_timer);
+
+    _fitness = target->normalisedError(error.load());
+    _fitness_exceeded = error.load() > limit;
+    GENERATOR_STATISTICS_ADD(_statistics, pixels, rendered_pixels.load());
+    GENERATOR_STATISTICS_ADD(_statistics, images, 1);
 }
 
 double ImageCPPNGeneratorNetwork::_getNeuronOutput(qint32 i)
 {
-    Q_UNUSED(i);
-    QNN_WARNING_MSG("This network does not generate usefull output");
-    return 0.0;
+    if(Q_UNLIKELY(_image.isNull()))
+    {
+        QNN_WARNING_MSG("No image has been generated yet");
+        return 0.0;
+    }
+    qint64 pixel = i / 3;
+    if(Q_UNLIKELY(i < 0 || pixel >= (qint64) _image.width() * (qint64) _image.height()))
+    {
+        QNN_WARNING_MSG(QString("Output %1 is outside of the image").arg(i));
+        return 0.0;
+    }
+    QRgb rgb = _image.pixel(pixel % _image.width(), pixel / _image.width());
+    switch(i % 3)
+    {
+    case 0:
+        return qRed(rgb) / 255.0;
+    case 1:
+        return qGreen(rgb) / 255.0;
+    default:
+        return qBlue(rgb) / 255.0;
+    }
 }
 
 bool ImageCPPNGeneratorNetwork::_saveNetworkConfig(QXmlStreamWriter *stream)
@@ -146,6 +608,14 @@ bool ImageCPPNGeneratorNetwork::_saveNetworkConfig(QXmlStreamWriter *stream)
     config_network["height"] = _config.height;
     config_network["min hidden neurons"] = _config.min_size;
     config_network["max hidden neurons"] = _config.max_size;
+    if(_config.save_statistics && GeneratorStatistics::enabled())
+    {
+        QMap<QString, QVariant> statistics = _statistics.toMap();
+        foreach(QString key, statistics.keys())
+        {
+            config_network[key] = statistics[key];
+        }
+    }
     writeConfigStart("ImageCPPNGeneratorNetwork", config_network, stream);
 
     for(qint32 neuron = 0; neuron < _gene->segments().size(); ++neuron)
@@ -153,45 +623,21 @@ bool ImageCPPNGeneratorNetwork::_saveNetworkConfig(QXmlStreamWriter *stream)
         QMap<QString, QVariant> config_neuron;
         QMap<qint32, double> connection_neuron;
 
-        QString function;
-        switch(qFloor(floatFromGeneInput(_gene->segments()[neuron][0], 6)))
-        {
-        case 0:
-            function = "cosinus";
-            break;
-        case 1:
-            function = "sinus";
-            break;
-        case 2:
-            function = "tanh";
-            break;
-        case 3:
-            function = "identity";
-            break;
-        case 4:
-            function = "gaussian";
-            break;
-        case 5:
-        case 6: // 6 is an extreme corner case which should almost never occure
-            function = "sigmoid";
-            break;
-        default:
-            function = "<unknown error>";
-        }
+        QString function = CPPNProgram::functionName(CPPNProgram::functionFromGene(_gene->segments()[neuron][0]));
 
         config_neuron["function"] = function;
 
-        for(qint32 input = 0; input < neuron + 4; ++input)
+        for(qint32 input = 0; input < neuron + INPUT_NEURONS; ++input)
         {
             if(_gene->segments()[neuron][1 + (2 * input)] % 2)
             {
-                if(input <= 3)
+                if(input < INPUT_NEURONS)
                 {
                     config_neuron[QString("input %1").arg(input)] = weight(_gene->segments()[neuron][1 + (2 * input) + 1], 1);
                 }
                 else
                 {
-                    connection_neuron[input - 4] = weight(_gene->segments()[neuron][1 + (2 * input) + 1], 1);
+                    connection_neuron[input - INPUT_NEURONS] = weight(_gene->segments()[neuron][1 + (2 * input) + 1], 1);
                 }
             }
         }
@@ -202,32 +648,508 @@ bool ImageCPPNGeneratorNetwork::_saveNetworkConfig(QXmlStreamWriter *stream)
     return true;
 }
 
-double ImageCPPNGeneratorNetwork::applyFunction(double value, qint32 geneValue)
+quint64 ImageCPPNGeneratorNetwork::renderKey(const CPPNProgram &program, const config &config)
 {
-    switch(qFloor(floatFromGeneInput(geneValue, 6)))
+    quint64 key = program.neuronCount() > 0 ? program.prefixHash(program.neuronCount() - 1) : CPPNProgram::combineHash(0, program.inputCount());
+    key = CPPNProgram::combineHash(key, (quint64) (quint32) config.width);
+    key = CPPNProgram::combineHash(key, (quint64) (quint32) config.height);
+    key = CPPNProgram::combineHash(key, (quint64) config.precision);
+    if(config.supersampling_samples > 1)
     {
-    case 0:
-        return qCos(value);
-        break;
-    case 1:
-        return qSin(value);
-        break;
-    case 2:
-        return tanh(value);
-        break;
-    case 3:
-        // Identity between 0,1
-        return qBound(0.0, value, 1.0);
-        break;
-    case 4:
-        return qExp(-1 * (qPow(value, 2)) / 0.5);
-        break;
-    case 5:
-    case 6: // 6 is an extreme corner case which should almost never occure
-        return sigmoid(value);
+        // Keys of images without supersampling stay unchanged
+        key = CPPNProgram::combineHash(key, (quint64) (quint32) config.supersampling_samples);
+        key = CPPNProgram::combineHash(key, (quint64) (quint32) config.supersampling_threshold);
+    }
+    return key;
+}
+
+void ImageCPPNGeneratorNetwork::renderRows(const CPPNProgram &program, const config &config, const CPPNCoordinates &coordinates, uchar *bits, qint32 bytes_per_line, qint32 first_row, qint32 last_row, const CPPNSeparableValues *separable, double time, CPPNRenderContext::scratch *scratch)
+{
+    CPPNRenderContext::scratch local_scratch;
+    if(scratch == NULL)
+    {
+        scratch = &local_scratch;
+    }
+    switch(config.precision)
+    {
+    case PRECISION_FLOAT:
+        if(config.batch_evaluation)
+        {
+            renderRowsBatch<float>(program, config, coordinates, bits, bytes_per_line, first_row, last_row, separable, time, *scratch);
+        }
+        else
+        {
+            renderRowsPixelwise<float>(program, config, coordinates, bits, bytes_per_line, first_row, last_row, separable, time, *scratch);
+        }
         break;
+    case PRECISION_DOUBLE:
     default:
+        if(config.batch_evaluation)
+        {
+            renderRowsBatch<double>(program, config, coordinates, bits, bytes_per_line, first_row, last_row, separable, time, *scratch);
+        }
+        else
+        {
+            renderRowsPixelwise<double>(program, config, coordinates, bits, bytes_per_line, first_row, last_row, separable, time, *scratch);
+        }
+        break;
+    }
+}
+
+void ImageCPPNGeneratorNetwork::renderRowsKernel(CPPNKernelCompiler::row_kernel kernel, const config &config, const CPPNCoordinates &coordinates, uchar *bits, qint32 bytes_per_line, qint32 first_row, qint32 last_row, double time, CPPNRenderContext::scratch *scratch)
+{
+    CPPNRenderContext::scratch local_scratch;
+    double *distance_scratch = (scratch != NULL ? scratch : &local_scratch)->distance(config.width);
+    for(qint32 height = first_row; height < last_row; ++height)
+    {
+        QRgb *line = reinterpret_cast<QRgb *>(bits + (qint64) (height - first_row) * bytes_per_line);
+        const double *distance = coordinates.distanceRow(height, distance_scratch);
+        kernel(coordinates.x(), coordinates.y()[height], distance, config.width, time, line, &CommonNetworkFunctions::sigmoid);
+    }
+}
+
+qint64 ImageCPPNGeneratorNetwork::supersample(const CPPNProgram &program, const config &config, uchar *bits, qint32 bytes_per_line)
+{
+    qint32 grid = qFloor(qSqrt(config.supersampling_samples));
+    if(grid <= 1)
+    {
+        return 0;
+    }
+
+    // All edge pixels are found before the first pixel is overwritten, so the search only sees the image with one sample per pixel
+    QVector<qint32> bands;
+    for(qint32 row = 0; row < config.height; row += config.band_height)
+    {
+        bands.append(row);
+    }
+    QVector< QVector<qint64> > pixels(bands.size());
+    auto find_band = [&config, bits, bytes_per_line, &bands, &pixels](qint32 band)
+    {
+        findEdgePixels(config, bits, bytes_per_line, bands[band], qMin(bands[band] + config.band_height, config.height), pixels[band]);
+    };
+    auto supersample_band = [&program, &config, grid, bits, bytes_per_line, &pixels](qint32 band)
+    {
+        if(config.precision == PRECISION_FLOAT)
+        {
+            supersamplePixels<float>(program, config, grid, bits, bytes_per_line, pixels[band]);
+        }
+        else
+        {
+            supersamplePixels<double>(program, config, grid, bits, bytes_per_line, pixels[band]);
+        }
+    };
+
+    QVector<qint32> band_numbers(bands.size());
+    for(qint32 band = 0; band < bands.size(); ++band)
+    {
+        band_numbers[band] = band;
+    }
+    if(config.parallel_rendering)
+    {
+        QtConcurrent::blockingMap(band_numbers, [&find_band](qint32 &band)
+        {
+            find_band(band);
+        });
+        QtConcurrent::blockingMap(band_numbers, [&supersample_band](qint32 &band)
+        {
+            supersample_band(band);
+        });
+    }
+    else
+    {
+        for(qint32 band = 0; band < bands.size(); ++band)
+        {
+            find_band(band);
+        }
+        for(qint32 band = 0; band < bands.size(); ++band)
+        {
+            supersample_band(band);
+        }
+    }
+
+    qint64 evaluations = 0;
+    for(qint32 band = 0; band < bands.size(); ++band)
+    {
+        evaluations += (qint64) pixels[band].size() * grid * grid;
+    }
+    return evaluations;
+}
+
+void ImageCPPNGeneratorNetwork::findEdgePixels(const config &config, const uchar *bits, qint32 bytes_per_line, qint32 first_row, qint32 last_row, QVector<qint64> &pixels)
+{
+    const qint32 threshold = config.supersampling_threshold;
+    auto differs = [threshold](QRgb a, QRgb b)
+    {
+        return qAbs(qRed(a) - qRed(b)) > threshold || qAbs(qGreen(a) - qGreen(b)) > threshold || qAbs(qBlue(a) - qBlue(b)) > threshold;
+    };
+
+    for(qint32 row = first_row; row < last_row; ++row)
+    {
+        const QRgb *line = reinterpret_cast<const QRgb *>(bits + (qint64) row * bytes_per_line);
+        const QRgb *above = row > 0 ? reinterpret_cast<const QRgb *>(bits + (qint64) (row - 1) * bytes_per_line) : NULL;
+        const QRgb *below = row + 1 < config.height ? reinterpret_cast<const QRgb *>(bits + (qint64) (row + 1) * bytes_per_line) : NULL;
+        for(qint32 column = 0; column < config.width; ++column)
+        {
+            QRgb pixel = line[column];
+            if((column > 0 && differs(pixel, line[column - 1])) ||
+                    (column + 1 < config.width && differs(pixel, line[column + 1])) ||
+                    (above != NULL && differs(pixel, above[column])) ||
+                    (below != NULL && differs(pixel, below[column])))
+            {
+                pixels.append((qint64) row * config.width + column);
+            }
+        }
+    }
+}
+
+template<typename T> void ImageCPPNGeneratorNetwork::supersamplePixels(const CPPNProgram &program, const config &config, qint32 grid, uchar *bits, qint32 bytes_per_line, const QVector<qint64> &pixels)
+{
+    const qint32 block = CPPNProgram::BLOCK_SIZE;
+    const qint32 samples = grid * grid;
+    QVector<T> network(program.networkSize() * block);
+    qint32 neurons = program.networkSize();
+    T *bias = network.data();
+    T *x = bias + block;
+    T *y = x + block;
+    T *distance = y + block;
+    const T *red = network.constData() + (neurons - 3) * block;
+    const T *green = network.constData() + (neurons - 2) * block;
+    const T *blue = network.constData() + (neurons - 1) * block;
+
+    // Same coordinate system as CPPNCoordinates, the sample of a pixel without supersampling lies in the center of the sub-pixel grid
+    double max_distance = qSqrt(qPow(config.width, 2) + qPow(config.height, 2))/2;
+    double x_center = config.width / 2;
+    double y_center = config.height / 2;
+
+    if(program.inputCount() > CPPNProgram::TIME_INPUT)
+    {
+        for(qint32 lane = 0; lane < block; ++lane)
+        {
+            network[CPPNProgram::TIME_INPUT * block + lane] = 0.0;
+        }
+    }
+
+    for(qint32 i = 0; i < pixels.size(); ++i)
+    {
+        qint32 row = pixels[i] / config.width;
+        qint32 column = pixels[i] % config.width;
+        double r = 0.0;
+        double g = 0.0;
+        double b = 0.0;
+
+        for(qint32 first_sample = 0; first_sample < samples; first_sample += block)
+        {
+            qint32 count = qMin(block, samples - first_sample);
+            for(qint32 lane = 0; lane < block; ++lane)
+            {
+                // Lanes behind the last sample repeat the last sample so every lane contains valid values
+                qint32 sample = first_sample + qMin(lane, count - 1);
+                double sample_x = column + ((sample % grid) + 0.5) / grid - 0.5;
+                double sample_y = row + ((sample / grid) + 0.5) / grid - 0.5;
+                bias[lane] = 1.0;
+                x[lane] = sample_x / config.width;
+                y[lane] = sample_y / config.height;
+                distance[lane] = qSqrt((sample_x - x_center) * (sample_x - x_center) + (sample_y - y_center) * (sample_y - y_center)) / max_distance;
+            }
+            program.evaluateBlock(network.data());
+            for(qint32 lane = 0; lane < count; ++lane)
+            {
+                r += qBound((T) 0.0, red[lane] * 255, (T) 255.0);
+                g += qBound((T) 0.0, green[lane] * 255, (T) 255.0);
+                b += qBound((T) 0.0, blue[lane] * 255, (T) 255.0);
+            }
+        }
+
+        QRgb *line = reinterpret_cast<QRgb *>(bits + (qint64) row * bytes_per_line);
+        line[column] = qRgb(qFloor(r / samples), qFloor(g / samples), qFloor(b / samples));
+    }
+}
+
+template<typename T> void ImageCPPNGeneratorNetwork::renderRowsPixelwise(const CPPNProgram &program, const config &config, const CPPNCoordinates &coordinates, uchar *bits, qint32 bytes_per_line, qint32 first_row, qint32 last_row, const CPPNSeparableValues *separable, double time, CPPNRenderContext::scratch &scratch)
+{
+    qint32 neurons = program.networkSize();
+    T *network = scratch.network<T>(neurons);
+    double *distance_scratch = scratch.distance(config.width);
+    qint32 *radius_scratch = scratch.radius(config.width);
+    std::fill(network, network + neurons, (T) 0.0);
+    const double *x = coordinates.x();
+    const double *y = coordinates.y();
+
+    // Inputs are never overwritten by the evaluation, so the time is only set once
+    if(program.inputCount() > CPPNProgram::TIME_INPUT)
+    {
+        network[CPPNProgram::TIME_INPUT] = time;
+    }
+    if(separable != NULL)
+    {
+        separable->setValues(network, CPPNProgram::STAGE_CONSTANT, 0);
+    }
+
+    for(qint32 height = first_row; height < last_row; ++height)
+    {
+        QRgb *line = reinterpret_cast<QRgb *>(bits + (qint64) (height - first_row) * bytes_per_line);
+        const double *distance = coordinates.distanceRow(height, distance_scratch);
+        const qint32 *radius = NULL;
+        if(separable != NULL)
+        {
+            separable->setValues(network, CPPNProgram::STAGE_ROW, height);
+            if(separable->radiusAvailable())
+            {
+                radius = coordinates.radiusIndexRow(height, radius_scratch);
+            }
+        }
+        for(qint32 width = 0; width < config.width; ++width)
+        {
+            network[0] = 1.0;
+            network[1] = x[width];
+            network[2] = y[height];
+            network[3] = distance[width];
+            if(separable == NULL)
+            {
+                program.evaluate(network);
+            }
+            else
+            {
+                separable->setValues(network, CPPNProgram::STAGE_COLUMN, width);
+                if(radius != NULL)
+                {
+                    separable->setValues(network, CPPNProgram::STAGE_RADIUS, radius[width]);
+                }
+                program.evaluateNeurons(network, separable->pixelNeurons());
+            }
+            qint32 r = qFloor(qBound((T) 0.0, network[neurons - 3] * 255, (T) 255.0));
+            qint32 g = qFloor(qBound((T) 0.0, network[neurons - 2] * 255, (T) 255.0));
+            qint32 b = qFloor(qBound((T) 0.0, network[neurons - 1] * 255, (T) 255.0));
+            line[width] = qRgb(r, g, b);
+        }
+    }
+}
+
+template<typename T> void ImageCPPNGeneratorNetwork::renderRowsBatch(const CPPNProgram &program, const config &config, const CPPNCoordinates &coordinates, uchar *bits, qint32 bytes_per_line, qint32 first_row, qint32 last_row, const CPPNSeparableValues *separable, double time, CPPNRenderContext::scratch &scratch)
+{
+    const qint32 block = CPPNProgram::BLOCK_SIZE;
+    qint32 neurons = program.networkSize();
+    T *network = scratch.network<T>(neurons * block);
+    double *distance_scratch = scratch.distance(config.width);
+    qint32 *radius_scratch = scratch.radius(config.width);
+    std::fill(network, network + neurons * block, (T) 0.0);
+    const double *x_coordinates = coordinates.x();
+    const double *y_coordinates = coordinates.y();
+    T *bias = network;
+    T *x = bias + block;
+    T *y = x + block;
+    T *distance = y + block;
+    const T *red = network + (neurons - 3) * block;
+    const T *green = network + (neurons - 2) * block;
+    const T *blue = network + (neurons - 1) * block;
+
+    if(program.inputCount() > CPPNProgram::TIME_INPUT)
+    {
+        for(qint32 lane = 0; lane < block; ++lane)
+        {
+            network[CPPNProgram::TIME_INPUT * block + lane] = time;
+        }
+    }
+    if(separable != NULL)
+    {
+        for(qint32 lane = 0; lane < block; ++lane)
+        {
+            separable->setValuesBlock(network, CPPNProgram::STAGE_CONSTANT, 0, lane);
+        }
+    }
+
+    for(qint32 height = first_row; height < last_row; ++height)
+    {
+        QRgb *line = reinterpret_cast<QRgb *>(bits + (qint64) (height - first_row) * bytes_per_line);
+        const double *distance_row = coordinates.distanceRow(height, distance_scratch);
+        const qint32 *radius = NULL;
+        if(separable != NULL)
+        {
+            for(qint32 lane = 0; lane < block; ++lane)
+            {
+                separable->setValuesBlock(network, CPPNProgram::STAGE_ROW, height, lane);
+            }
+            if(separable->radiusAvailable())
+            {
+                radius = coordinates.radiusIndexRow(height, radius_scratch);
+            }
+        }
+        for(qint32 first_column = 0; first_column < config.width; first_column += block)
+        {
+            qint32 pixels = qMin(block, config.width - first_column);
+            for(qint32 lane = 0; lane < block; ++lane)
+            {
+                // Lanes behind the end of the row repeat the last pixel so every lane contains valid values
+                qint32 width = first_column + qMin(lane, pixels - 1);
+                bias[lane] = 1.0;
+                x[lane] = x_coordinates[width];
+                y[lane] = y_coordinates[height];
+                distance[lane] = distance_row[width];
+                if(separable != NULL)
+                {
+                    separable->setValuesBlock(network, CPPNProgram::STAGE_COLUMN, width, lane);
+                    if(radius != NULL)
+                    {
+                        separable->setValuesBlock(network, CPPNProgram::STAGE_RADIUS, radius[width], lane);
+                    }
+                }
+            }
+            if(separable == NULL)
+            {
+                program.evaluateBlock(network);
+            }
+            else
+            {
+                program.evaluateNeuronsBlock(network, separable->pixelNeurons());
+            }
+            for(qint32 lane = 0; lane < pixels; ++lane)
+            {
+                qint32 r = qFloor(qBound((T) 0.0, red[lane] * 255, (T) 255.0));
+                qint32 g = qFloor(qBound((T) 0.0, green[lane] * 255, (T) 255.0));
+                qint32 b = qFloor(qBound((T) 0.0, blue[lane] * 255, (T) 255.0));
+                line[first_column + lane] = qRgb(r, g, b);
+            }
+        }
+    }
+}
+
+qint64 ImageCPPNGeneratorNetwork::renderPlanes(const CPPNProgram &program, const config &config, const CPPNCoordinates &coordinates, uchar *bits, qint32 bytes_per_line)
+{
+    CPPNActivationCache *cache = config.activation_cache;
+    qint32 width = config.width;
+    qint32 pixels = config.width * config.height;
+    qint32 inputs = program.inputCount();
+    qint32 neurons = program.neuronCount();
+    QVector<double *> planes(inputs + neurons);
+    QVector<CPPNActivationCache::plane> neuron_planes(neurons);
+
+    // Reuse the planes of all neurons up to the first neuron not in the cache
+    qint32 first_changed = 0;
+    while(first_changed < neurons)
+    {
+        CPPNActivationCache::plane activations = cache->find(CPPNActivationCache::key(program.prefixHash(first_changed), config.width, config.height));
+        if(activations.isNull())
+        {
+            break;
+        }
+        neuron_planes[first_changed] = activations;
+        // The plane is only read, evaluatePlaneRows() writes to planes of neurons starting at first_changed
+        planes[inputs + first_changed] = const_cast<double *>(activations->constData());
+        ++first_changed;
+    }
+
+    if(first_changed < neurons)
+    {
+        QVector<double> input_planes(inputs * pixels);
+        QVector<double> distance_scratch(width);
+        for(qint32 input = 0; input < inputs; ++input)
+        {
+            planes[input] = input_planes.data() + input * pixels;
+        }
+        for(qint32 row = 0; row < config.height; ++row)
+        {
+            const double *distance = coordinates.distanceRow(row, distance_scratch.data());
+            for(qint32 column = 0; column < width; ++column)
+            {
+                qint32 pixel = row * width + column;
+                planes[0][pixel] = 1.0;
+                planes[1][pixel] = coordinates.x()[column];
+                planes[2][pixel] = coordinates.y()[row];
+                planes[3][pixel] = distance[column];
+            }
+        }
+
+        for(qint32 neuron = first_changed; neuron < neurons; ++neuron)
+        {
+            QVector<double> *activations = new QVector<double>(pixels);
+            planes[inputs + neuron] = activations->data();
+            neuron_planes[neuron] = CPPNActivationCache::plane(activations);
+        }
+
+        if(config.parallel_rendering)
+        {
+            QVector<qint32> bands;
+            for(qint32 row = 0; row < config.height; row += config.band_height)
+            {
+                bands.append(row);
+            }
+            QtConcurrent::blockingMap(bands, [&program, &planes, &config, first_changed](qint32 &first_row)
+            {
+                evaluatePlaneRows(program, planes, first_changed, config.width, first_row, qMin(first_row + config.band_height, config.height));
+            });
+        }
+        else
+        {
+            evaluatePlaneRows(program, planes, first_changed, config.width, 0, config.height);
+        }
+
+        for(qint32 neuron = first_changed; neuron < neurons; ++neuron)
+        {
+            cache->insert(CPPNActivationCache::key(program.prefixHash(neuron), config.width, config.height), neuron_planes[neuron]);
+        }
+    }
+
+    const double *red = planes[inputs + neurons - 3];
+    const double *green = planes[inputs + neurons - 2];
+    const double *blue = planes[inputs + neurons - 1];
+    for(qint32 row = 0; row < config.height; ++row)
+    {
+        QRgb *line = reinterpret_cast<QRgb *>(bits + (qint64) row * bytes_per_line);
+        for(qint32 column = 0; column < width; ++column)
+        {
+            qint32 pixel = row * width + column;
+            qint32 r = qFloor(qBound(0.0, red[pixel] * 255, 255.0));
+            qint32 g = qFloor(qBound(0.0, green[pixel] * 255, 255.0));
+            qint32 b = qFloor(qBound(0.0, blue[pixel] * 255, 255.0));
+            line[column] = qRgb(r, g, b);
+        }
+    }
+
+    qint64 connections = 0;
+    for(qint32 neuron = first_changed; neuron < neurons; ++neuron)
+    {
+        connections += program.neurons()[neuron].connection_count;
+    }
+    return connections * pixels;
+}
+
+void ImageCPPNGeneratorNetwork::evaluatePlaneRows(const CPPNProgram &program, const QVector<double *> &planes, qint32 first_neuron, qint32 width, qint32 first_row, qint32 last_row)
+{
+    const CPPNProgram::connection *connections = program.connections().constData();
+    qint32 inputs = program.inputCount();
+    qint32 offset = first_row * width;
+    qint32 count = (last_row - first_row) * width;
+
+    for(qint32 neuron = first_neuron; neuron < program.neuronCount(); ++neuron)
+    {
+        const CPPNProgram::neuron &n = program.neurons()[neuron];
+        double *value = planes[inputs + neuron] + offset;
+        for(qint32 pixel = 0; pixel < count; ++pixel)
+        {
+            value[pixel] = 0.0;
+        }
+        for(qint32 c = n.first_connection; c < n.first_connection + n.connection_count; ++c)
+        {
+            const double *input = planes[connections[c].input] + offset;
+            double weight = connections[c].weight;
+            for(qint32 pixel = 0; pixel < count; ++pixel)
+            {
+                value[pixel] += input[pixel] * weight;
+            }
+        }
+        for(qint32 pixel = 0; pixel < count; ++pixel)
+        {
+            value[pixel] = CPPNProgram::applyFunction(value[pixel], n.function);
+        }
+    }
+}
+
+double ImageCPPNGeneratorNetwork::applyFunction(double value, qint32 geneValue)
+{
+    CPPNProgram::activation_function function = CPPNProgram::functionFromGene(geneValue);
+    if(Q_UNLIKELY(function == CPPNProgram::FUNCTION_UNKNOWN))
+    {
         QNN_CRITICAL_MSG("Unknown function" << qFloor(floatFromGeneInput(geneValue, 5)));
-        return value;
     }
+    return CPPNProgram::applyFunction(value, function);
 }
@@ -20,10 +20,15 @@
 
 #include <network/networktoxml.h>
 #include <network/commonnetworkfunctions.h>
+#include <network/generatorsnapshot.h>
+#include <image/imagewriter.h>
+#include <image/ppmstripwriter.h>
 
 #include <limits>
 #include <QMap>
 #include <QImage>
+#include <QFileInfo>
+#include <QVector>
 #include<QtCore/qmath.h>
 
 using NetworkToXML::writeConfigStart;
@@ -33,7 +38,19 @@ using CommonNetworkFunctions::floatFromGeneInput;
 ImageDirectEncodingGeneratorNetwork::ImageDirectEncodingGeneratorNetwork(qint32 len_input, qint32 len_output, config config) :
     AbstractNeuralNetwork(len_input, len_output),
     _config(config),
-    _size(0)
+    _size(0),
+    _genome_width(0),
+    _genome_height(0),
+    _genome_size(0),
+    _upsampler(),
+    _genome_scratch(),
+    _upsampler_scratch(),
+    _fitness_scratch(),
+    _image(),
+    _buffer_gene(NULL),
+    _fitness(0.0),
+    _fitness_exceeded(false),
+    _statistics()
 {
     if(Q_UNLIKELY(_config.width <= 0))
     {
@@ -43,12 +60,32 @@ ImageDirectEncodingGeneratorNetwork::ImageDirectEncodingGeneratorNetwork(qint32
     {
         QNN_FATAL_MSG("Width must be greater than 0");
     }
-    qint64 size = _config.width * _config.height;
+    if(Q_UNLIKELY(_config.strip_height < 0))
+    {
+        QNN_FATAL_MSG("Strip height must not be negative");
+    }
+    qint64 size = (qint64) _config.width * (qint64) _config.height;
     if(Q_UNLIKELY(size > std::numeric_limits<qint32>::max()))
     {
         QNN_FATAL_MSG("Size gets to huge, decrease width or height");
     }
     _size = size;
+    if(Q_UNLIKELY(_config.genome_scale <= 0))
+    {
+        QNN_FATAL_MSG("Genome scale must be greater than 0");
+    }
+    _genome_width = (_config.width + _config.genome_scale - 1) / _config.genome_scale;
+    _genome_height = (_config.height + _config.genome_scale - 1) / _config.genome_scale;
+    _genome_size = _genome_width * _genome_height;
+    if(_config.genome_scale > 1)
+    {
+        _upsampler = QSharedPointer<const ImageUpsampler>(new ImageUpsampler(_genome_width, _genome_height, _config.width, _config.height, _config.interpolation));
+        _upsampler_scratch.resize(_genome_width * 3);
+    }
+    if(Q_UNLIKELY(_config.target_fitness != NULL && (_config.target_fitness->width() != _config.width || _config.target_fitness->height() != _config.height)))
+    {
+        QNN_FATAL_MSG("Size of the target image does not fit");
+    }
 }
 
 ImageDirectEncodingGeneratorNetwork::~ImageDirectEncodingGeneratorNetwork()
@@ -57,7 +94,11 @@ ImageDirectEncodingGeneratorNetwork::~ImageDirectEncodingGeneratorNetwork()
 
 GenericGene *ImageDirectEncodingGeneratorNetwork::getRandomGene()
 {
-    return new GenericGene(_size, 3);
+    if(_config.buffer_gene)
+    {
+        return new RGBBufferGene(_genome_size);
+    }
+    return new GenericGene(_genome_size, 3);
 }
 
 AbstractNeuralNetwork *ImageDirectEncodingGeneratorNetwork::createConfigCopy()
@@ -65,16 +106,75 @@ AbstractNeuralNetwork *ImageDirectEncodingGeneratorNetwork::createConfigCopy()
     return new ImageDirectEncodingGeneratorNetwork(_len_input, _len_output, _config);
 }
 
+qint32 ImageDirectEncodingGeneratorNetwork::genomeWidth() const
+{
+    return _genome_width;
+}
+
+qint32 ImageDirectEncodingGeneratorNetwork::genomeHeight() const
+{
+    return _genome_height;
+}
+
+QImage ImageDirectEncodingGeneratorNetwork::getImage() const
+{
+    return _image;
+}
+
+double ImageDirectEncodingGeneratorNetwork::fitness() const
+{
+    return _fitness;
+}
+
+bool ImageDirectEncodingGeneratorNetwork::fitnessThresholdExceeded() const
+{
+    return _fitness_exceeded;
+}
+
+GeneratorStatistics ImageDirectEncodingGeneratorNetwork::statistics() const
+{
+    return _statistics;
+}
+
+void ImageDirectEncodingGeneratorNetwork::resetStatistics()
+{
+    _statistics.reset();
+}
+
 ImageDirectEncodingGeneratorNetwork::ImageDirectEncodingGeneratorNetwork() :
     AbstractNeuralNetwork(),
     _config(),
-    _size(0)
+    _size(0),
+    _genome_width(0),
+    _genome_height(0),
+    _genome_size(0),
+    _upsampler(),
+    _genome_scratch(),
+    _upsampler_scratch(),
+    _fitness_scratch(),
+    _image(),
+    _buffer_gene(NULL),
+    _fitness(0.0),
+    _fitness_exceeded(false),
+    _statistics()
 {
 }
 
 void ImageDirectEncodingGeneratorNetwork::_initialise()
 {
-    if(Q_UNLIKELY(_gene->segments().size() != _size))
+    GENERATOR_STATISTICS_START(decode_timer);
+    _buffer_gene = dynamic_cast<RGBBufferGene *>(_gene);
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, decode_nsecs, decode_timer);
+    if(_buffer_gene != NULL)
+    {
+        if(Q_UNLIKELY(_buffer_gene->pixels() != _genome_size))
+        {
+            QNN_FATAL_MSG("Gene length does not fit");
+        }
+        return;
+    }
+
+    if(Q_UNLIKELY(_gene->segments().size() != _genome_size))
     {
         QNN_FATAL_MSG("Gene length does not fit");
     }
@@ -87,31 +187,271 @@ void ImageDirectEncodingGeneratorNetwork::_initialise()
 void ImageDirectEncodingGeneratorNetwork::_processInput(QList<double> input)
 {
     Q_UNUSED(input);
-    QImage image(_config.width, _config.height, QImage::Format_RGB32);
+    if(_config.target_fitness != NULL)
+    {
+        evaluateFitness();
+        return;
+    }
+    if(_config.strip_height > 0 && _config.save_image)
+    {
+        writeStrips();
+        return;
+    }
+
+    GENERATOR_STATISTICS_START(image_timer);
+
+    if(!_upsampler.isNull())
+    {
+        prepareImage();
+        _upsampler->upsample(genomeRGB(), 0, _config.height, _image.bits(), _image.bytesPerLine(), _upsampler_scratch.data());
+    }
+    else if(_buffer_gene != NULL)
+    {
+        // The buffer of the gene already has the layout of Format_RGB888, so it is used as image without copying.
+        // The image keeps a shared copy of the buffer so it stays valid even if the gene is deleted or modified.
+        // Modifying the gene detaches its buffer, so the image only still points to the buffer if the gene is unchanged.
+        const QByteArray &gene_buffer = _buffer_gene->buffer();
+        if(_image.format() != QImage::Format_RGB888 || _image.constBits() != reinterpret_cast<const uchar *>(gene_buffer.constData()))
+        {
+            QByteArray *buffer = new QByteArray(gene_buffer);
+            _image = QImage(reinterpret_cast<const uchar *>(buffer->constData()), _config.width, _config.height, _config.width * 3, QImage::Format_RGB888, &deleteBuffer, buffer);
+        }
+    }
+    else
+    {
+        prepareImage();
+        uchar *bits = _image.bits();
+        qint32 bytes_per_line = _image.bytesPerLine();
+
+        for(qint32 height = 0; height < _config.height; ++height)
+        {
+            decodeRow(height, reinterpret_cast<QRgb *>(bits + (qint64) height * bytes_per_line));
+        }
+    }
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, image_nsecs, image_timer);
+    GENERATOR_STATISTICS_ADD(_statistics, pixels, _size);
+    GENERATOR_STATISTICS_ADD(_statistics, images, 1);
+
+    if(_config.save_image)
+    {
+        GENERATOR_STATISTICS_START(save_timer);
+        if(_config.asynchronous_save)
+        {
+            ImageWriter::globalInstance()->write(_image, _config.image_path, _config.image_format, _config.image_quality);
+        }
+        else
+        {
+            ImageWriter::writeImage(_image, _config.image_path, _config.image_format, _config.image_quality);
+            GENERATOR_STATISTICS_ADD(_statistics, bytes_written, QFileInfo(_config.image_path).size());
+        }
+        GENERATOR_STATISTICS_ADD_TIME(_statistics, save_nsecs, save_timer);
+    }
+}
+
+void ImageDirectEncodingGeneratorNetwork::writeStrips()
+{
+    _image = QImage();
+    qint32 strip_height = qMin(_config.strip_height, _config.height);
+    PPMStripWriter writer;
+
+    if(!writer.open(_config.image_path, _config.width, _config.height))
+    {
+        return;
+    }
+
+    GENERATOR_STATISTICS_START(save_timer);
+    if(!_upsampler.isNull())
+    {
+        const uchar *source = genomeRGB();
+        QImage strip(_config.width, strip_height, QImage::Format_RGB32);
+
+        for(qint32 first_row = 0; first_row < _config.height; first_row += strip_height)
+        {
+            qint32 rows = qMin(strip_height, _config.height - first_row);
+            _upsampler->upsample(source, first_row, rows, strip.bits(), strip.bytesPerLine(), _upsampler_scratch.data());
+            if(!writer.writeRows(strip, rows))
+            {
+                break;
+            }
+        }
+    }
+    else if(_buffer_gene != NULL)
+    {
+        // The buffer already has the layout of a PPM file, so it is written without conversion
+        const uchar *data = reinterpret_cast<const uchar *>(_buffer_gene->buffer().constData());
+        for(qint32 first_row = 0; first_row < _config.height; first_row += strip_height)
+        {
+            qint32 rows = qMin(strip_height, _config.height - first_row);
+            if(!writer.writeRGB(data + (qint64) first_row * _config.width * 3, rows))
+            {
+                break;
+            }
+        }
+    }
+    else
+    {
+        QImage strip(_config.width, strip_height, QImage::Format_RGB32);
+        uchar *bits = strip.bits();
+        qint32 bytes_per_line = strip.bytesPerLine();
+
+        for(qint32 first_row = 0; first_row < _config.height; first_row += strip_height)
+        {
+            qint32 rows = qMin(strip_height, _config.height - first_row);
+            for(qint32 row = 0; row < rows; ++row)
+            {
+                decodeRow(first_row + row, reinterpret_cast<QRgb *>(bits + (qint64) row * bytes_per_line));
+            }
+            if(!writer.writeRows(strip, rows))
+            {
+                break;
+            }
+        }
+    }
+    writer.close();
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, save_nsecs, save_timer);
+    GENERATOR_STATISTICS_ADD(_statistics, pixels, _size);
+    GENERATOR_STATISTICS_ADD(_statistics, images, 1);
+    GENERATOR_STATISTICS_ADD(_statistics, bytes_written, QFileInfo(_config.image_path).size());
+}
+
+void ImageDirectEncodingGeneratorNetwork::evaluateFitness()
+{
+    _image = QImage();
+    const ImageTargetFitness *target = _config.target_fitness;
+    qint64 limit = target->errorLimit(_config.fitness_threshold);
+    qint64 error = 0;
+    qint32 row = 0;
 
-    for(qint32 height = 0; height < _config.height; ++height)
+    GENERATOR_STATISTICS_START(evaluation_timer);
+    if(!_upsampler.isNull())
     {
-        for(qint32 width = 0; width < _config.width; ++width)
+        // The rows are upsampled in small bands, so the intermediate row of the upsampler is reused between rows of a band
+        const qint32 band_height = 16;
+        const uchar *source = genomeRGB();
+        if(_fitness_scratch.size() < band_height * _config.width)
         {
-            qint32 r = qFloor(floatFromGeneInput(_gene->segments()[_config.width * height + width][0], 255));
-            qint32 g = qFloor(floatFromGeneInput(_gene->segments()[_config.width * height + width][1], 255));
-            qint32 b = qFloor(floatFromGeneInput(_gene->segments()[_config.width * height + width][2], 255));
-            QRgb pixel = qRgb(r, g, b);
-            image.setPixel(width, height, pixel);
+            _fitness_scratch.resize(band_height * _config.width);
+        }
+        QRgb *band = _fitness_scratch.data();
+        while(row < _config.height && error <= limit)
+        {
+            qint32 rows = qMin(band_height, _config.height - row);
+            _upsampler->upsample(source, row, rows, reinterpret_cast<uchar *>(band), _config.width * sizeof(QRgb), _upsampler_scratch.data());
+            for(qint32 i = 0; i < rows && error <= limit; ++i, ++row)
+            {
+                error += target->error(band + i * _config.width, row, 1);
+            }
         }
     }
+    else if(_buffer_gene != NULL)
+    {
+        const uchar *data = reinterpret_cast<const uchar *>(_buffer_gene->buffer().constData());
+        for(; row < _config.height && error <= limit; ++row)
+        {
+            error += target->errorRGB(data + (qint64) row * _config.width * 3, row, 1);
+        }
+    }
+    else
+    {
+        if(_fitness_scratch.size() < _config.width)
+        {
+            _fitness_scratch.resize(_config.width);
+        }
+        QRgb *line = _fitness_scratch.data();
+        for(; row < _config.height && error <= limit; ++row)
+        {
+            decodeRow(row, line);
+            error += target->error(line, row, 1);
+        }
+    }
+    GENERATOR_STATISTICS_ADD_TIME(_statistics, evaluation_nsecs, evaluation_timer);
+
+    _fitness = target->normalisedError(error);
+    _fitness_exceeded = error > limit;
+    GENERATOR_STATISTICS_ADD(_statistics, pixels, (qint64) row * _config.width);
+    GENERATOR_STATISTICS_ADD(_statistics, images, 1);
+}
 
-    if(!image.save(_config.image_path))
+void ImageDirectEncodingGeneratorNetwork::decodeRow(qint32 row, QRgb *line)
+{
+    const QList< QList<qint32> > &segments = _gene->segments();
+    for(qint32 width = 0; width < _config.width; ++width)
     {
-        QNN_WARNING_MSG(QString("Could not save image to %1").arg(_config.image_path));
+        const QList<qint32> &segment = segments[_config.width * row + width];
+        qint32 r = qFloor(floatFromGeneInput(segment[0], 255));
+        qint32 g = qFloor(floatFromGeneInput(segment[1], 255));
+        qint32 b = qFloor(floatFromGeneInput(segment[2], 255));
+        line[width] = qRgb(r, g, b);
+    }
+}
+
+const uchar *ImageDirectEncodingGeneratorNetwork::genomeRGB()
+{
+    if(_buffer_gene != NULL)
+    {
+        return reinterpret_cast<const uchar *>(_buffer_gene->buffer().constData());
+    }
+
+    const QList< QList<qint32> > &segments = _gene->segments();
+    _genome_scratch.resize(_genome_size * 3);
+    uchar *data = reinterpret_cast<uchar *>(_genome_scratch.data());
+    for(qint32 pixel = 0; pixel < _genome_size; ++pixel)
+    {
+        const QList<qint32> &segment = segments[pixel];
+        for(qint32 channel = 0; channel < 3; ++channel)
+        {
+            data[pixel * 3 + channel] = qFloor(floatFromGeneInput(segment[channel], 255));
+        }
+    }
+    return data;
+}
+
+void ImageDirectEncodingGeneratorNetwork::prepareImage()
+{
+    if(_image.width() != _config.width || _image.height() != _config.height || _image.format() != QImage::Format_RGB32 || !_image.isDetached())
+    {
+        _image = QImage(_config.width, _config.height, QImage::Format_RGB32);
     }
 }
 
 double ImageDirectEncodingGeneratorNetwork::_getNeuronOutput(qint32 i)
 {
-    Q_UNUSED(i);
-    QNN_WARNING_MSG("This network does not generate usefull output");
-    return 0.0;
+    if(Q_UNLIKELY(_image.isNull()))
+    {
+        QNN_WARNING_MSG("No image has been generated yet");
+        return 0.0;
+    }
+    qint64 pixel = i / 3;
+    if(Q_UNLIKELY(i < 0 || pixel >= (qint64) _image.width() * (qint64) _image.height()))
+    {
+        QNN_WARNING_MSG(QString("Output %1 is outside of the image").arg(i));
+        return 0.0;
+    }
+    QRgb rgb = _image.pixel(pixel % _image.width(), pixel / _image.width());
+    switch(i % 3)
+    {
+    case 0:
+        return qRed(rgb) / 255.0;
+    case 1:
+        return qGreen(rgb) / 255.0;
+    default:
+        return qBlue(rgb) / 255.0;
+    }
+}
+
+bool ImageDirectEncodingGeneratorNetwork::saveSnapshot(const QString &path)
+{
+    if(Q_UNLIKELY(_gene == NULL))
+    {
+        QNN_WARNING_MSG("Network is not initialised");
+        return false;
+    }
+    return GeneratorSnapshot::write(GeneratorSnapshot::fromDirectEncoding(genomeRGB(), _genome_width, _genome_height, _config), path);
+}
+
+void ImageDirectEncodingGeneratorNetwork::deleteBuffer(void *buffer)
+{
+    delete static_cast<QByteArray *>(buffer);
 }
 
 bool ImageDirectEncodingGeneratorNetwork::_saveNetworkConfig(QXmlStreamWriter *stream)
@@ -120,6 +460,19 @@ bool ImageDirectEncodingGeneratorNetwork::_saveNetworkConfig(QXmlStreamWriter *s
     config_network["width"] = _config.width;
     config_network["height"] = _config.height;
     config_network["Save path"] = _config.image_path;
+    if(_config.genome_scale > 1)
+    {
+        config_network["genome scale"] = _config.genome_scale;
+        config_network["interpolation"] = (qint32) _config.interpolation;
+    }
+    if(_config.save_statistics && GeneratorStatistics::enabled())
+    {
+        QMap<QString, QVariant> statistics = _statistics.toMap();
+        foreach(QString key, statistics.keys())
+        {
+            config_network[key] = statistics[key];
+        }
+    }
     writeConfigStart("ImageDirectEncodingGeneratorNetwork", config_network, stream);
     writeConfigEnd(stream);
     return true;
@@ -22,11 +22,25 @@
 #include <qnn-global.h>
 
 #include <network/abstractneuralnetwork.h>
+#include <network/rgbbuffergene.h>
+#include <network/generatorstatistics.h>
+#include <image/imagetargetfitness.h>
+#include <image/imageupsampler.h>
+
+#include <limits>
+#include <QImage>
+#include <QSharedPointer>
 
 /*!
  * \brief The ImageDirectEncodingGeneratorNetwork class is a special network that do not generate output but creates images out of a gene.
  *
- * The image is encoded into three values: red, green, blue. Each pixel of the image is encoded in an own gene segment.
+ * The image is encoded into three values: red, green, blue.
+ * By default getRandomGene() returns a GenericGene with one segment of size 3 per pixel. If buffer_gene is set it returns a RGBBufferGene
+ * which stores all pixels in one contiguous buffer instead. Both kinds of genes are accepted independent of buffer_gene.
+ * With genome_scale the gene only encodes a coarser grid, which is upsampled to the size of the image.
+ *
+ * The image and all scratch memory are kept between evaluations. Calling processInput() again without save_image does not allocate memory,
+ * as long as the previous image is not referenced anymore.
  *
  * The ImageDirectEncodingGeneratorNetwork is not a neural network. It is a special wrapper to create images using QNeuralNetwork.
  */
@@ -53,13 +67,115 @@ public:
          */
         QString image_path;
 
+        /*!
+         * \brief If true the resulting image is saved to image_path
+         *
+         * If false the image is only kept in memory and can be accessed through getImage() and getNeuronOutput(qint32 i).
+         */
+        bool save_image;
+
+        /*!
+         * \brief The format used to save the image (e.g. "PNG", "PPM", "BMP")
+         *
+         * If empty, the format is deduced from the suffix of image_path.
+         * Uncompressed formats like "PPM" or "BMP" are much faster to write than "PNG".
+         */
+        QByteArray image_format;
+
+        /*!
+         * \brief The quality passed to QImage::save()
+         *
+         * -1 uses the default of the format.
+         * For "PNG" 100 means no compression and 0 means maximum compression. A value of 85 results in zlib compression level 1.
+         */
+        qint32 image_quality;
+
+        /*!
+         * \brief If true the image is saved on a background thread using ImageWriter::globalInstance()
+         *
+         * Call ImageWriter::globalInstance()->waitForDone() to make sure all images are written.
+         */
+        bool asynchronous_save;
+
+        /*!
+         * \brief If true the recorded statistics are saved as additional attributes by saveNetworkConfig()
+         *
+         * Has no effect if the library is built without QNN_IMAGE_GENERATORS_STATISTICS.
+         */
+        bool save_statistics;
+
+        /*!
+         * \brief Height of the strips if the image is streamed to disk. 0 disables streaming
+         *
+         * If greater than 0 and save_image is true, the image is converted strip by strip and every strip is appended to a binary PPM file
+         * at image_path (see PPMStripWriter). Only one strip is kept in memory, so images bigger than the available memory can be saved.
+         * image_format, image_quality and asynchronous_save are ignored and no image is kept (getImage() returns a null image).
+         */
+        qint32 strip_height;
+
+        /*!
+         * \brief Target image for the fitness evaluation. NULL disables the fitness evaluation
+         *
+         * If set, processInput() does not create an image. The pixels of the gene are compared with the target row by row (see fitness()).
+         * A RGBBufferGene is compared directly without any conversion if genome_scale is 1.
+         * The size of the target must be width x height. save_image and strip_height are ignored.
+         *
+         * The target is not owned by the network and can be shared between networks. It must outlive all networks using it.
+         */
+        ImageTargetFitness *target_fitness;
+
+        /*!
+         * \brief Error at which the fitness evaluation is stopped
+         *
+         * The error is checked after every row. As soon as it exceeds fitness_threshold (see ImageTargetFitness::normalisedError()),
+         * no further rows are compared and fitnessThresholdExceeded() returns true. Infinity disables the early termination.
+         */
+        double fitness_threshold;
+
+        /*!
+         * \brief Factor by which the grid encoded by the gene is smaller than the image. 1 encodes every pixel
+         *
+         * The gene encodes genomeWidth() x genomeHeight() pixels (width and height divided by genome_scale, rounded up). The grid is upsampled to
+         * width x height with interpolation whenever an image is created, streamed or compared with target_fitness, so the image keeps its size.
+         * The memory of the gene and the cost of mutation and crossover shrink by genome_scale^2, e.g. a scale of 8 turns a 1024x1024 image
+         * into a gene of 128x128 pixels.
+         *
+         * Must be greater than 0. If greater than 1, the image always has Format_RGB32.
+         */
+        qint32 genome_scale;
+
+        /*!
+         * \brief Interpolation used to upsample the grid of the gene. Only used if genome_scale is greater than 1
+         */
+        ImageUpsampler::interpolation_mode interpolation;
+
+        /*!
+         * \brief If true getRandomGene() returns a RGBBufferGene instead of a GenericGene with segments
+         *
+         * A RGBBufferGene needs much less memory and is mutated, combined, rendered and compared with target_fitness without conversion.
+         * Its segments() are empty and it is not saved or loaded through the segments of GenericGene,
+         * so it should only be used if the genes are not serialised or accessed through segments().
+         */
+        bool buffer_gene;
+
         /*!
          * \brief Constructor for standard values
          */
         config() :
             width(256),
             height(256),
-            image_path("./qnn-image-generators-direct-encoding.png")
+            image_path("./qnn-image-generators-direct-encoding.png"),
+            save_image(true),
+            image_format(),
+            image_quality(-1),
+            asynchronous_save(false),
+            save_statistics(false),
+            strip_height(0),
+            target_fitness(NULL),
+            fitness_threshold(std::numeric_limits<double>::infinity()),
+            genome_scale(1),
+            interpolation(ImageUpsampler::INTERPOLATION_BILINEAR),
+            buffer_gene(false)
         {
         }
     };
@@ -79,7 +195,7 @@ public:
 
     /*!
      * \brief Returns a random gene which may be used with the current network configuration
-     * \return Random gene. The caller must delete the gene
+     * \return Random gene, a RGBBufferGene if buffer_gene is set. The caller must delete the gene
      */
     GenericGene *getRandomGene();
 
@@ -89,6 +205,69 @@ public:
      */
     AbstractNeuralNetwork *createConfigCopy();
 
+    /*!
+     * \brief Returns the width of the grid encoded by the gene
+     * \return Width in pixel. Equals width if genome_scale is 1
+     */
+    qint32 genomeWidth() const;
+
+    /*!
+     * \brief Returns the height of the grid encoded by the gene
+     * \return Height in pixel. Equals height if genome_scale is 1
+     */
+    qint32 genomeHeight() const;
+
+    /*!
+     * \brief Returns the image generated by the last call of processInput(QList<double> input)
+     *
+     * The image is implicitly shared, so no pixel data is copied.
+     * If the network uses a RGBBufferGene and genome_scale is 1 the image has Format_RGB888 and directly uses the buffer of the gene.
+     * The raw RGB data can be accessed through QImage::constBits() or QImage::constScanLine(int i).
+     *
+     * \return Generated image. Null image if no image was generated yet
+     */
+    QImage getImage() const;
+
+    /*!
+     * \brief Saves the pixels encoded by the gene and the configuration needed to create the image as GeneratorSnapshot
+     *
+     * Only the genomeWidth() x genomeHeight() pixels of the gene are stored, the image is upsampled when the snapshot is rendered.
+     *
+     * \param path Path of the snapshot file
+     * \return True on success. False if the network is not initialised or the file could not be written
+     */
+    bool saveSnapshot(const QString &path);
+
+    /*!
+     * \brief Returns the error of the last image compared with target_fitness
+     *
+     * Only calculated if target_fitness is set.
+     *
+     * \return Mean error per channel between 0 (identical to the target) and 1 (see ImageTargetFitness::normalisedError()).
+     *         If fitnessThresholdExceeded() is true, the comparison was stopped early and the value is a lower bound of the error
+     */
+    double fitness() const;
+
+    /*!
+     * \brief Returns whether the error of the last image exceeded fitness_threshold
+     * \return True if the error exceeded fitness_threshold
+     */
+    bool fitnessThresholdExceeded() const;
+
+    /*!
+     * \brief Returns the statistics recorded by the network
+     *
+     * Statistics are only recorded if the library is built with QNN_IMAGE_GENERATORS_STATISTICS (see GeneratorStatistics).
+     *
+     * \return Statistics accumulated since the construction of the network or the last call of resetStatistics()
+     */
+    GeneratorStatistics statistics() const;
+
+    /*!
+     * \brief Resets all recorded statistics to 0
+     */
+    void resetStatistics();
+
 protected:
     /*!
      * \brief Empty constructor
@@ -115,10 +294,12 @@ protected:
     /*!
      * \brief Overwritten function to get output
      *
-     * In this network the getNeuronOutput(qint32 i) function should never be called.
+     * The output of this network are the channels of the generated image.
+     * Output i is channel (i % 3) (red, green, blue) of pixel (i / 3), pixels are counted row by row.
+     * To access all channels the network has to be created with len_output = width * height * 3.
      *
      * \param i Number of neuron (0 <= i < len_output)
-     * \return Output of neuron i. Always 0.o
+     * \return Value of the channel between 0 and 1
      */
     double _getNeuronOutput(qint32 i);
 
@@ -129,6 +310,12 @@ protected:
      */
     bool _saveNetworkConfig(QXmlStreamWriter *stream);
 
+    /*!
+     * \brief Cleanup function for images using the buffer of a RGBBufferGene
+     * \param buffer Pointer to the QByteArray kept alive by the image
+     */
+    static void deleteBuffer(void *buffer);
+
 private:
 
     /*!
@@ -142,6 +329,99 @@ private:
      *  This value is precalculated in the constructor. It equals to width * height.
      */
     qint32 _size;
+
+    /*!
+     * \brief Width of the grid encoded by the gene
+     */
+    qint32 _genome_width;
+
+    /*!
+     * \brief Height of the grid encoded by the gene
+     */
+    qint32 _genome_height;
+
+    /*!
+     * \brief Number of pixels encoded by the gene. Equals _genome_width * _genome_height
+     */
+    qint32 _genome_size;
+
+    /*!
+     * \brief Upsampler from the grid of the gene to the image. NULL if genome_scale is 1
+     */
+    QSharedPointer<const ImageUpsampler> _upsampler;
+
+    /*!
+     * \brief Grid of a gene made of segments converted by genomeRGB(). Kept to reuse the memory
+     */
+    QByteArray _genome_scratch;
+
+    /*!
+     * \brief Vertically interpolated row of the upsampler. Kept to reuse the memory
+     */
+    QVector<qint32> _upsampler_scratch;
+
+    /*!
+     * \brief Decoded or upsampled rows compared with target_fitness. Kept to reuse the memory
+     */
+    QVector<QRgb> _fitness_scratch;
+
+    /*!
+     * \brief The image generated by the last call of _processInput(QList<double> input)
+     */
+    QImage _image;
+
+    /*!
+     * \brief The gene as RGBBufferGene. NULL if the network is initialised with a GenericGene
+     */
+    RGBBufferGene *_buffer_gene;
+
+    /*!
+     * \brief Writes the image strip by strip to image_path. Used if strip_height is greater than 0
+     */
+    void writeStrips();
+
+    /*!
+     * \brief Compares the gene row by row with target_fitness. Used if target_fitness is set
+     */
+    void evaluateFitness();
+
+    /*!
+     * \brief Converts a row of a gene made of segments
+     * \param row Number of the row
+     * \param line Destination for width pixels
+     */
+    void decodeRow(qint32 row, QRgb *line);
+
+    /*!
+     * \brief Returns the grid encoded by the gene as RGB buffer for the upsampler
+     *
+     * A RGBBufferGene is returned directly, a gene made of segments is converted into _genome_scratch.
+     *
+     * \return RGB buffer of size _genome_size * 3
+     */
+    const uchar *genomeRGB();
+
+    /*!
+     * \brief Makes _image a writable image of the configured size in Format_RGB32
+     *
+     * The memory of the last image is reused if it is not shared with another QImage (see CPPNRenderContext::prepareImage()).
+     */
+    void prepareImage();
+
+    /*!
+     * \brief Error of the last image compared with target_fitness
+     */
+    double _fitness;
+
+    /*!
+     * \brief True if the error of the last image exceeded fitness_threshold
+     */
+    bool _fitness_exceeded;
+
+    /*!
+     * \brief Statistics recorded by the network
+     */
+    GeneratorStatistics _statistics;
 };
 
 #endif // IMAGEDIRECTENCODINGGENERATORNETWORK_H
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rgbbuffergene.h"
+
+#include <randomhelper.h>
+
+#include <limits>
+#include <string.h>
+#include <QtCore/qmath.h>
+
+RGBBufferGene::RGBBufferGene(qint32 pixels, config config) :
+    GenericGene(),
+    _buffer(),
+    _config(config)
+{
+    if(Q_UNLIKELY(pixels <= 0))
+    {
+        QNN_FATAL_MSG("Number of pixels must be greater than 0");
+    }
+    if(Q_UNLIKELY(pixels > std::numeric_limits<qint32>::max() / 3))
+    {
+        QNN_FATAL_MSG("Number of pixels gets to huge");
+    }
+    _buffer.resize(pixels * 3);
+    char *data = _buffer.data();
+    for(qint32 i = 0; i < _buffer.size(); ++i)
+    {
+        data[i] = (char) RandomHelper::getRandomInt(0, 255);
+    }
+}
+
+RGBBufferGene::RGBBufferGene(QByteArray buffer, config config) :
+    GenericGene(),
+    _buffer(buffer),
+    _config(config)
+{
+    if(Q_UNLIKELY(_buffer.size() % 3 != 0))
+    {
+        QNN_FATAL_MSG("Buffer size must be a multiple of 3");
+    }
+}
+
+RGBBufferGene::~RGBBufferGene()
+{
+}
+
+GenericGene *RGBBufferGene::mutate()
+{
+    QByteArray buffer = _buffer;
+    double chance = _config.mutation_chance < 0.0 ? 1.0 / (double) buffer.size() : _config.mutation_chance;
+
+    if(chance >= 1.0)
+    {
+        char *data = buffer.data();
+        for(qint32 i = 0; i < buffer.size(); ++i)
+        {
+            data[i] = (char) RandomHelper::getRandomInt(0, 255);
+        }
+    }
+    else if(chance > 0.0)
+    {
+        // Instead of drawing a random number for every byte the distance to the next mutated byte is drawn from a geometric distribution
+        char *data = buffer.data();
+        double log_keep = qLn(1.0 - chance);
+        qint64 position = -1;
+        forever
+        {
+            double random = RandomHelper::getRandomDouble(0.0, 1.0);
+            if(random <= 0.0)
+            {
+                random = std::numeric_limits<double>::min();
+            }
+            position += 1 + (qint64) qFloor(qLn(random) / log_keep);
+            if(position >= buffer.size() || position < 0)
+            {
+                break;
+            }
+            data[position] = (char) RandomHelper::getRandomInt(0, 255);
+        }
+    }
+
+    return new RGBBufferGene(buffer, _config);
+}
+
+QList<GenericGene *> RGBBufferGene::combine(GenericGene *gene1, GenericGene *gene2)
+{
+    RGBBufferGene *parent1 = dynamic_cast<RGBBufferGene *>(gene1);
+    RGBBufferGene *parent2 = dynamic_cast<RGBBufferGene *>(gene2);
+    if(Q_UNLIKELY(parent1 == NULL || parent2 == NULL))
+    {
+        QNN_FATAL_MSG("RGBBufferGene can only be combined with RGBBufferGene");
+    }
+    if(Q_UNLIKELY(parent1->_buffer.size() != parent2->_buffer.size()))
+    {
+        QNN_FATAL_MSG("Genes must have the same size");
+    }
+
+    qint32 size = parent1->_buffer.size();
+    qint32 start = RandomHelper::getRandomInt(0, size);
+    qint32 end = RandomHelper::getRandomInt(0, size);
+    if(start > end)
+    {
+        qSwap(start, end);
+    }
+
+    QByteArray child1 = parent1->_buffer;
+    QByteArray child2 = parent2->_buffer;
+    if(end > start)
+    {
+        memcpy(child1.data() + start, parent2->_buffer.constData() + start, end - start);
+        memcpy(child2.data() + start, parent1->_buffer.constData() + start, end - start);
+    }
+
+    QList<GenericGene *> children;
+    children.append(new RGBBufferGene(child1, _config));
+    children.append(new RGBBufferGene(child2, _config));
+    return children;
+}
+
+qint32 RGBBufferGene::pixels() const
+{
+    return _buffer.size() / 3;
+}
+
+const QByteArray &RGBBufferGene::buffer() const
+{
+    return _buffer;
+}
+
+QByteArray &RGBBufferGene::buffer()
+{
+    return _buffer;
+}
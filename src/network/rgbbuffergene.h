@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RGBBUFFERGENE_H
+#define RGBBUFFERGENE_H
+
+#include <qnn-global.h>
+
+#include <network/genericgene.h>
+
+#include <QByteArray>
+
+/*!
+ * \brief The RGBBufferGene class is a gene storing the pixels of an image in one contiguous buffer.
+ *
+ * Every pixel is stored as three bytes (red, green, blue), pixels are stored row by row.
+ * Mutation and crossover work directly on the buffer, so no per pixel allocations are needed.
+ *
+ * The buffer is implicitly shared. Copying a gene does not copy the buffer until one of the copies is modified.
+ *
+ * The RGBBufferGene does not use the segments of GenericGene, segments() is always empty.
+ * Code which saves, loads or inspects genes through segments() therefore only sees an empty gene.
+ * ImageDirectEncodingGeneratorNetwork only creates RGBBufferGene if its buffer_gene option is set.
+ */
+
+class QNNSHARED_EXPORT RGBBufferGene : public GenericGene
+{
+public:
+    /*!
+     * \brief This struct contains all configuration option of the RGBBufferGene
+     */
+    struct config {
+
+        /*!
+         * \brief Chance that a single byte is replaced by a random value during mutation
+         *
+         * If the value is negative, the chance is 1 / (number of bytes).
+         */
+        double mutation_chance;
+
+        /*!
+         * \brief Constructor for standard values
+         */
+        config() :
+            mutation_chance(-1.0)
+        {
+        }
+    };
+
+    /*!
+     * \brief Constructor for a random gene
+     * \param pixels Number of pixels. Must be greater than zero
+     * \param config Configuration of the gene
+     */
+    RGBBufferGene(qint32 pixels, config config = config());
+
+    /*!
+     * \brief Constructor for a gene with the given buffer
+     * \param buffer RGB buffer. The size must be a multiple of 3
+     * \param config Configuration of the gene
+     */
+    RGBBufferGene(QByteArray buffer, config config = config());
+
+    /*!
+     * \brief Destructor
+     */
+    ~RGBBufferGene();
+
+    /*!
+     * \brief Creates a mutated copy of the gene
+     *
+     * Every byte is replaced by a random value with a chance of mutation_chance.
+     *
+     * \return Mutated gene. The caller must delete the gene
+     */
+    GenericGene *mutate();
+
+    /*!
+     * \brief Combines two genes using a two point crossover on the buffer
+     * \param gene1 First gene. Must be a RGBBufferGene
+     * \param gene2 Second gene. Must be a RGBBufferGene of the same size
+     * \return Two new genes. The caller must delete the genes
+     */
+    QList<GenericGene *> combine(GenericGene *gene1, GenericGene *gene2);
+
+    /*!
+     * \brief Returns the number of pixels in the gene
+     * \return Number of pixels
+     */
+    qint32 pixels() const;
+
+    /*!
+     * \brief Returns the RGB buffer
+     * \return Buffer of size pixels() * 3
+     */
+    const QByteArray &buffer() const;
+
+    /*!
+     * \brief Returns the RGB buffer for modification
+     * \return Buffer of size pixels() * 3
+     */
+    QByteArray &buffer();
+
+private:
+    /*!
+     * \brief The RGB buffer
+     */
+    QByteArray _buffer;
+
+    /*!
+     * \brief The configuration of the gene
+     */
+    config _config;
+};
+
+#endif // RGBBUFFERGENE_H
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "batchrenderer.h"
+
+#include <image/imagewriter.h>
+
+#include <algorithm>
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QHash>
+#include <QtConcurrent/QtConcurrentMap>
+
+BatchRenderer::BatchRenderer(config config) :
+    _config(config)
+{
+    if(Q_UNLIKELY(_config.width < 0 || _config.height < 0))
+    {
+        QNN_FATAL_MSG("Width and height must not be negative");
+    }
+    if(Q_UNLIKELY(_config.scale <= 0.0))
+    {
+        QNN_FATAL_MSG("Scale must be greater than 0");
+    }
+    if(Q_UNLIKELY(_config.threads < 0))
+    {
+        QNN_FATAL_MSG("Threads must not be negative");
+    }
+}
+
+qint32 BatchRenderer::run(QTextStream &stream)
+{
+    qint32 threads = _config.threads > 0 ? _config.threads : qMax(1, QThread::idealThreadCount());
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    QElapsedTimer wall_timer;
+    wall_timer.start();
+
+    QVector<job> jobs(_config.files.size());
+    QVector<qint32> order(jobs.size());
+    for(qint32 i = 0; i < jobs.size(); ++i)
+    {
+        jobs[i].file = _config.files[i];
+        order[i] = i;
+    }
+    forEachJob(jobs, order, threads, [this](job &job, qint32 worker)
+    {
+        Q_UNUSED(worker);
+        loadJob(job);
+    });
+    assignOutputs(jobs);
+
+    // Largest jobs first, so the last jobs to finish are the cheap ones
+    std::stable_sort(order.begin(), order.end(), [&jobs](qint32 a, qint32 b)
+    {
+        return jobs[a].cost > jobs[b].cost;
+    });
+    // With fewer jobs than threads the idle threads render bands of the CPPN images
+    bool parallel_rendering = jobs.size() < threads;
+    forEachJob(jobs, order, threads, [this, parallel_rendering](job &job, qint32 worker)
+    {
+        job.worker = worker;
+        if(job.success)
+        {
+            renderJob(job, parallel_rendering);
+        }
+    });
+    qint64 wall_nsecs = wall_timer.nsecsElapsed();
+
+    stream << "file,network,width,height,worker,load_seconds,render_seconds,save_seconds,pixels_per_second,output" << endl;
+    qint32 failed = 0;
+    double pixels = 0.0;
+    foreach(const job &job, jobs)
+    {
+        QString network = "failed";
+        if(job.success)
+        {
+            network = job.type == GeneratorSnapshot::SNAPSHOT_CPPN ? "cppn" : "direct_encoding";
+            pixels += (double) job.width * (double) job.height;
+        }
+        else
+        {
+            ++failed;
+        }
+        double render_seconds = job.render_nsecs / 1e9;
+        stream << job.file << ","
+               << network << ","
+               << job.width << ","
+               << job.height << ","
+               << job.worker << ","
+               << QString::number(job.load_nsecs / 1e9, 'g', 6) << ","
+               << QString::number(render_seconds, 'g', 6) << ","
+               << QString::number(job.save_nsecs / 1e9, 'g', 6) << ","
+               << QString::number(job.success && render_seconds > 0 ? (double) job.width * (double) job.height / render_seconds : 0.0, 'g', 6) << ","
+               << job.output << endl;
+    }
+
+    double wall_seconds = wall_nsecs / 1e9;
+    stream << endl;
+    stream << "jobs,failed,threads,pixels,wall_seconds,images_per_second,pixels_per_second" << endl;
+    stream << jobs.size() << ","
+           << failed << ","
+           << threads << ","
+           << QString::number(pixels, 'f', 0) << ","
+           << QString::number(wall_seconds, 'g', 6) << ","
+           << QString::number(wall_seconds > 0 ? (jobs.size() - failed) / wall_seconds : 0.0, 'g', 6) << ","
+           << QString::number(wall_seconds > 0 ? pixels / wall_seconds : 0.0, 'g', 6) << endl;
+    return failed;
+}
+
+QStringList BatchRenderer::findFiles(const QString &path, const QStringList &filters)
+{
+    QFileInfo info(path);
+    if(!info.isDir())
+    {
+        return QStringList(path);
+    }
+    QDir directory(path);
+    QStringList files;
+    foreach(QString file, directory.entryList(filters, QDir::Files, QDir::Name))
+    {
+        files.append(directory.filePath(file));
+    }
+    return files;
+}
+
+void BatchRenderer::loadJob(job &job)
+{
+    job.type = GeneratorSnapshot::SNAPSHOT_INVALID;
+    job.width = 0;
+    job.height = 0;
+    job.cost = 0.0;
+    job.worker = -1;
+    job.load_nsecs = 0;
+    job.render_nsecs = 0;
+    job.save_nsecs = 0;
+
+    GeneratorSnapshot snapshot;
+    job.success = snapshot.open(job.file);
+    if(!job.success)
+    {
+        return;
+    }
+
+    job.type = snapshot.type();
+    job.width = _config.width > 0 ? _config.width : qMax(1, qRound(snapshot.width() * _config.scale));
+    job.height = _config.height > 0 ? _config.height : qMax(1, qRound(snapshot.height() * _config.scale));
+    job.cost = (double) job.width * (double) job.height;
+    if(job.type == GeneratorSnapshot::SNAPSHOT_CPPN)
+    {
+        job.cost *= snapshot.program().connections().size() + snapshot.program().neuronCount();
+    }
+}
+
+void BatchRenderer::assignOutputs(QVector<job> &jobs) const
+{
+    QHash<QString, QList<qint32> > base_names;
+    for(qint32 i = 0; i < jobs.size(); ++i)
+    {
+        base_names[QFileInfo(jobs[i].file).completeBaseName()].append(i);
+    }
+
+    QVector<QString> names(jobs.size());
+    foreach(QString base_name, base_names.keys())
+    {
+        QList<qint32> group = base_names.value(base_name);
+        if(group.size() == 1)
+        {
+            names[group.first()] = base_name;
+            continue;
+        }
+
+        // Files with the same name are named after their path relative to the deepest common directory
+        QVector<QStringList> directories(group.size());
+        for(qint32 j = 0; j < group.size(); ++j)
+        {
+            directories[j] = QFileInfo(jobs[group[j]].file).absolutePath().split('/', QString::SkipEmptyParts);
+        }
+        qint32 common = directories[0].size();
+        for(qint32 j = 1; j < group.size(); ++j)
+        {
+            qint32 shared = 0;
+            while(shared < qMin(common, directories[j].size()) && directories[j][shared] == directories[0][shared])
+            {
+                ++shared;
+            }
+            common = shared;
+        }
+        for(qint32 j = 0; j < group.size(); ++j)
+        {
+            QStringList parts = directories[j].mid(common);
+            parts.append(base_name);
+            names[group[j]] = parts.join('_');
+        }
+    }
+
+    QString suffix = QString(_config.image_format).toLower();
+    QDir directory(_config.output_directory);
+    QHash<QString, qint32> outputs;
+    for(qint32 i = 0; i < jobs.size(); ++i)
+    {
+        jobs[i].output = directory.filePath(QString("%1.%2").arg(names[i]).arg(suffix));
+        if(outputs.contains(jobs[i].output))
+        {
+            QNN_WARNING_MSG(QString("%1 and %2 would both be saved to %3, %2 is skipped").arg(jobs[outputs.value(jobs[i].output)].file).arg(jobs[i].file).arg(jobs[i].output));
+            jobs[i].success = false;
+        }
+        else
+        {
+            outputs.insert(jobs[i].output, i);
+        }
+    }
+}
+
+void BatchRenderer::renderJob(job &job, bool parallel_rendering)
+{
+    QElapsedTimer timer;
+    timer.start();
+    GeneratorSnapshot snapshot;
+    job.success = snapshot.open(job.file);
+    job.load_nsecs = timer.nsecsElapsed();
+    if(!job.success)
+    {
+        return;
+    }
+
+    timer.restart();
+    QImage image;
+    if(snapshot.type() == GeneratorSnapshot::SNAPSHOT_CPPN)
+    {
+        ImageCPPNGeneratorNetwork::config stored = snapshot.cppnConfig();
+        ImageCPPNGeneratorNetwork::config config = _config.cppn_config;
+        config.width = job.width;
+        config.height = job.height;
+        config.precision = stored.precision;
+        config.supersampling_samples = stored.supersampling_samples;
+        config.supersampling_threshold = stored.supersampling_threshold;
+        config.parallel_rendering = parallel_rendering;
+        image = ImageCPPNGeneratorNetwork::renderProgram(snapshot.program(), config);
+    }
+    else
+    {
+        image = snapshot.image(job.width, job.height);
+    }
+    job.render_nsecs = timer.nsecsElapsed();
+
+    timer.restart();
+    job.success = !image.isNull() && ImageWriter::writeImage(image, job.output, _config.image_format, _config.image_quality);
+    job.save_nsecs = timer.nsecsElapsed();
+}
+
+template<class Function> void BatchRenderer::forEachJob(QVector<job> &jobs, const QVector<qint32> &order, qint32 threads, Function function)
+{
+    QVector<qint32> workers(qBound(1, threads, qMax(1, jobs.size())));
+    for(qint32 i = 0; i < workers.size(); ++i)
+    {
+        workers[i] = i;
+    }
+    QAtomicInt next_job(0);
+    QtConcurrent::blockingMap(workers, [&jobs, &order, &next_job, &function](qint32 &worker)
+    {
+        for(qint32 i = next_job.fetchAndAddRelaxed(1); i < order.size(); i = next_job.fetchAndAddRelaxed(1))
+        {
+            function(jobs[order[i]], worker);
+        }
+    });
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <network/imagecppngeneratornetwork.h>
+#include <network/generatorsnapshot.h>
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+/*!
+ * \brief The BatchRenderer class renders many GeneratorSnapshot files on all cores and saves the images.
+ *
+ * Every snapshot is one job. The headers of the snapshots are read in parallel first, afterwards the jobs are sorted by their estimated cost
+ * (pixels times connections of a CPPN) and started largest first. Every worker thread takes the next job from a shared atomic index
+ * as soon as it is idle, so expensive jobs do not wait behind a fixed partition and the cheap jobs at the end fill the gaps.
+ * Every job is rendered in its worker thread. If there are fewer jobs than threads, the CPPN images are additionally rendered in parallel bands,
+ * so the remaining threads are not idle.
+ *
+ * An image is saved with the name of its snapshot and the suffix of the format. If several snapshots have the same name,
+ * their images are named after the path relative to the deepest common directory instead, with "_" as separator
+ * (e.g. a/x.snapshot and b/x.snapshot are saved as a_x.png and b_x.png). A job whose output would still overwrite the image of
+ * another job (e.g. the same file passed twice) fails.
+ *
+ * The results are written as CSV. Every job is written as one line with the columns
+ * file, network, width, height, worker, load_seconds, render_seconds, save_seconds, pixels_per_second, output.
+ * Failed jobs have the network "failed". After an empty line the aggregate is written with the columns
+ * jobs, failed, threads, pixels, wall_seconds, images_per_second, pixels_per_second.
+ */
+
+class BatchRenderer
+{
+public:
+    /*!
+     * \brief This struct contains all configuration option of the batch renderer
+     */
+    struct config {
+        /*!
+         * \brief Snapshot files to render
+         */
+        QStringList files;
+
+        /*!
+         * \brief Directory the images are saved to. Must exist
+         */
+        QString output_directory;
+
+        /*!
+         * \brief Width of the images in pixel. 0 uses the stored width multiplied by scale
+         */
+        qint32 width;
+
+        /*!
+         * \brief Height of the images in pixel. 0 uses the stored height multiplied by scale
+         */
+        qint32 height;
+
+        /*!
+         * \brief Factor applied to the stored size if width or height is 0
+         */
+        double scale;
+
+        /*!
+         * \brief Format of the images (e.g. "PNG", "PPM"). Also used as suffix of the files
+         */
+        QByteArray image_format;
+
+        /*!
+         * \brief The quality passed to QImage::save(). -1 uses the default of the format
+         */
+        qint32 image_quality;
+
+        /*!
+         * \brief Number of worker threads. 0 uses QThread::idealThreadCount()
+         */
+        qint32 threads;
+
+        /*!
+         * \brief Template for the evaluation of CPPN snapshots
+         *
+         * Size, precision and supersampling are taken from the snapshot. parallel_rendering is enabled if there are fewer jobs than threads
+         * and disabled otherwise, because the jobs run in parallel.
+         * Evaluation options like batch_evaluation, separable_evaluation or kernel_compiler are used as set.
+         */
+        ImageCPPNGeneratorNetwork::config cppn_config;
+
+        /*!
+         * \brief Constructor for standard values
+         */
+        config() :
+            files(),
+            output_directory("."),
+            width(0),
+            height(0),
+            scale(1.0),
+            image_format("PNG"),
+            image_quality(-1),
+            threads(0),
+            cppn_config()
+        {
+        }
+    };
+
+    /*!
+     * \brief Constructor
+     * \param config Configuration of the batch renderer
+     */
+    BatchRenderer(config config = config());
+
+    /*!
+     * \brief Renders all snapshots
+     * \param stream Stream the CSV lines are written to
+     * \return Number of failed jobs
+     */
+    qint32 run(QTextStream &stream);
+
+    /*!
+     * \brief Finds snapshot files
+     * \param path A snapshot file or a directory
+     * \param filters Name filters for the files of a directory (e.g. "*.snapshot")
+     * \return path if it is a file, otherwise all matching files of the directory sorted by name
+     */
+    static QStringList findFiles(const QString &path, const QStringList &filters);
+
+private:
+    /*!
+     * \brief A snapshot to render
+     */
+    struct job {
+        QString file;
+        GeneratorSnapshot::snapshot_type type;
+        qint32 width;
+        qint32 height;
+        double cost;
+        qint32 worker;
+        qint64 load_nsecs;
+        qint64 render_nsecs;
+        qint64 save_nsecs;
+        QString output;
+        bool success;
+    };
+
+    /*!
+     * \brief Reads the snapshot of a job and calculates size and cost
+     *
+     * The snapshot is closed again, so the number of open files does not grow with the number of jobs.
+     *
+     * \param job Job
+     */
+    void loadJob(job &job);
+
+    /*!
+     * \brief Sets the output paths of the jobs, so no two jobs save to the same file
+     *
+     * Jobs whose output is not unique fail.
+     *
+     * \param jobs Jobs
+     */
+    void assignOutputs(QVector<job> &jobs) const;
+
+    /*!
+     * \brief Loads the snapshot of a job, renders and saves the image
+     * \param job Job
+     * \param parallel_rendering If true CPPN images are rendered in parallel bands
+     */
+    void renderJob(job &job, bool parallel_rendering);
+
+    /*!
+     * \brief Runs a function for all jobs on the worker threads
+     *
+     * Every worker takes the next index of order until all jobs are processed.
+     *
+     * \param jobs Jobs
+     * \param order Indices of the jobs in the order they are started
+     * \param threads Number of worker threads
+     * \param function Function called with a job and the number of the worker
+     */
+    template<class Function> static void forEachJob(QVector<job> &jobs, const QVector<qint32> &order, qint32 threads, Function function);
+
+    config _config;
+};
+
+#endif // BATCHRENDERER_H
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "batchrenderer.h"
+
+#include <network/cppnkernelcompiler.h>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("qnn-image-generators-batchrender");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders snapshots of ImageCPPNGeneratorNetwork and ImageDirectEncodingGeneratorNetwork (see saveSnapshot()) on all cores. "
+                                     "The throughput of every job and of the whole batch is written as CSV.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("paths", "Snapshot files or directories containing snapshot files.", "[paths...]");
+
+    QCommandLineOption list_option("list", "Text file with one snapshot file or directory per line.", "file");
+    QCommandLineOption filter_option("filter", "Comma separated list of name filters for the files of a directory.", "filters", "*.snapshot");
+    QCommandLineOption output_option("output", "Directory the images are saved to.", "directory", ".");
+    QCommandLineOption width_option("width", "Width of the images (0: stored width times scale).", "pixels", "0");
+    QCommandLineOption height_option("height", "Height of the images (0: stored height times scale).", "pixels", "0");
+    QCommandLineOption scale_option("scale", "Factor applied to the stored size.", "factor", "1");
+    QCommandLineOption format_option("format", "Image format of the saved images.", "format", "PNG");
+    QCommandLineOption quality_option("quality", "Quality passed to QImage::save() (-1: default of the format).", "quality", "-1");
+    QCommandLineOption threads_option("threads", "Number of worker threads (0: all cores).", "count", "0");
+    QCommandLineOption batch_option("batch", "Enable batch_evaluation of CPPN snapshots.");
+    QCommandLineOption separable_option("separable", "Enable separable_evaluation of CPPN snapshots.");
+    QCommandLineOption kernel_option("native-kernels", "Compile CPPN snapshots into native kernels.");
+    QCommandLineOption report_option("report", "Write the results to file instead of stdout.", "file");
+
+    parser.addOption(list_option);
+    parser.addOption(filter_option);
+    parser.addOption(output_option);
+    parser.addOption(width_option);
+    parser.addOption(height_option);
+    parser.addOption(scale_option);
+    parser.addOption(format_option);
+    parser.addOption(quality_option);
+    parser.addOption(threads_option);
+    parser.addOption(batch_option);
+    parser.addOption(separable_option);
+    parser.addOption(kernel_option);
+    parser.addOption(report_option);
+    parser.process(a);
+
+    BatchRenderer::config config;
+    bool ok = true;
+    bool all_ok = true;
+
+    config.width = parser.value(width_option).toInt(&ok);
+    all_ok &= ok && config.width >= 0;
+    config.height = parser.value(height_option).toInt(&ok);
+    all_ok &= ok && config.height >= 0;
+    config.scale = parser.value(scale_option).toDouble(&ok);
+    all_ok &= ok && config.scale > 0.0;
+    config.image_quality = parser.value(quality_option).toInt(&ok);
+    all_ok &= ok;
+    config.threads = parser.value(threads_option).toInt(&ok);
+    all_ok &= ok && config.threads >= 0;
+
+    QStringList paths = parser.positionalArguments();
+    if(parser.isSet(list_option))
+    {
+        QFile list(parser.value(list_option));
+        if(!list.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            qCritical() << "Can not open" << list.fileName();
+            return 1;
+        }
+        QTextStream list_stream(&list);
+        while(!list_stream.atEnd())
+        {
+            QString path = list_stream.readLine().trimmed();
+            if(!path.isEmpty())
+            {
+                paths.append(path);
+            }
+        }
+    }
+    QStringList filters = parser.value(filter_option).split(",", QString::SkipEmptyParts);
+    foreach(QString path, paths)
+    {
+        config.files.append(BatchRenderer::findFiles(path, filters));
+    }
+    all_ok &= !config.files.isEmpty();
+
+    if(!all_ok)
+    {
+        qCritical() << "Invalid arguments";
+        parser.showHelp(1);
+    }
+
+    config.output_directory = parser.value(output_option);
+    if(!QDir().mkpath(config.output_directory))
+    {
+        qCritical() << "Can not create" << config.output_directory;
+        return 1;
+    }
+    config.image_format = parser.value(format_option).toLatin1();
+    config.cppn_config.batch_evaluation = parser.isSet(batch_option);
+    config.cppn_config.separable_evaluation = parser.isSet(separable_option);
+    CPPNKernelCompiler kernel_compiler;
+    config.cppn_config.kernel_compiler = parser.isSet(kernel_option) ? &kernel_compiler : NULL;
+
+    QFile file;
+    if(parser.isSet(report_option))
+    {
+        file.setFileName(parser.value(report_option));
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        {
+            qCritical() << "Can not open" << file.fileName();
+            return 1;
+        }
+    }
+    else
+    {
+        file.open(stdout, QIODevice::WriteOnly);
+    }
+    QTextStream stream(&file);
+
+    BatchRenderer renderer(config);
+    qint32 failed = renderer.run(stream);
+
+    return failed == 0 ? 0 : 1;
+}
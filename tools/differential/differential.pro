@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Differential correctness harness for the rendering paths of qnn-image-generators
+#
+#-------------------------------------------------
+
+QT       += core concurrent
+
+TARGET = qnn-image-generators-differential
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += src/ ../../src/ ../../../qnn/src
+
+unix: LIBS += -L$$PWD/../../ -lqnn-image-generators -L$$PWD/../../../qnn/ -lqnn
+win32: LIBS += -L$$PWD/../../ -lqnn-image-generators0 -L$$PWD/../../../qnn/ -lqnn0
+
+QMAKE_CXXFLAGS += -std=c++11
+
+SOURCES += \
+    src/main.cpp \
+    src/differentialharness.cpp
+
+HEADERS += \
+    src/differentialharness.h
+
+DESTDIR = $$PWD
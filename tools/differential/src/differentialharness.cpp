@@ -0,0 +1,698 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "differentialharness.h"
+
+#include <network/generatorsnapshot.h>
+#include <network/commonnetworkfunctions.h>
+#include <image/imagerendercache.h>
+#include <image/imagetargetfitness.h>
+
+#include <math.h>
+#include <limits>
+#include <QFile>
+#include <QtCore/qmath.h>
+#include <QtConcurrent/QtConcurrentMap>
+
+using CommonNetworkFunctions::sigmoid;
+using CommonNetworkFunctions::weight;
+using CommonNetworkFunctions::floatFromGeneInput;
+
+const char *DifferentialHarness::CPPN_NETWORK = "cppn";
+const char *DifferentialHarness::DIRECT_ENCODING_NETWORK = "direct_encoding";
+const char *DifferentialHarness::ANIMATION_NETWORK = "animation";
+
+DifferentialHarness::DifferentialHarness(config config) :
+    _config(config),
+    _activation_cache(),
+    _modes(),
+    _directory()
+{
+    if(Q_UNLIKELY(_config.genomes <= 0))
+    {
+        QNN_FATAL_MSG("Genomes must be greater than 0");
+    }
+    foreach(neuron_range range, _config.neuron_ranges)
+    {
+        if(Q_UNLIKELY(range.min_size < 0 || range.max_size <= range.min_size))
+        {
+            QNN_FATAL_MSG("Max size must be greater than min size");
+        }
+    }
+    foreach(QSize size, _config.sizes)
+    {
+        if(Q_UNLIKELY(size.width() <= 0 || size.height() <= 0))
+        {
+            QNN_FATAL_MSG("Width and height must be greater than 0");
+        }
+    }
+
+    ImageCPPNGeneratorNetwork::config base;
+    base.save_image = false;
+    ImageCPPNGeneratorNetwork::config config_mode;
+
+    // Exact modes have to be identical to the reference
+    addMode(CPPN_NETWORK, "program", METHOD_NETWORK, base, 0, 0.0);
+    config_mode = base;
+    config_mode.batch_evaluation = true;
+    addMode(CPPN_NETWORK, "batch", METHOD_NETWORK, config_mode, 0, 0.0);
+    config_mode = base;
+    config_mode.separable_evaluation = true;
+    addMode(CPPN_NETWORK, "separable", METHOD_NETWORK, config_mode, 0, 0.0);
+    config_mode.batch_evaluation = true;
+    addMode(CPPN_NETWORK, "batch_separable", METHOD_NETWORK, config_mode, 0, 0.0);
+    config_mode = base;
+    config_mode.parallel_rendering = true;
+    config_mode.band_height = 7;
+    addMode(CPPN_NETWORK, "parallel", METHOD_NETWORK, config_mode, 0, 0.0);
+    config_mode.batch_evaluation = true;
+    addMode(CPPN_NETWORK, "parallel_batch", METHOD_NETWORK, config_mode, 0, 0.0);
+    config_mode = base;
+    config_mode.activation_cache = &_activation_cache;
+    addMode(CPPN_NETWORK, "activation_cache", METHOD_NETWORK, config_mode, 0, 0.0);
+    config_mode = base;
+    config_mode.band_height = 5;
+    addMode(CPPN_NETWORK, "population", METHOD_POPULATION, config_mode, 0, 0.0);
+    addMode(CPPN_NETWORK, "snapshot", METHOD_SNAPSHOT, base, 0, 0.0);
+    config_mode = base;
+    config_mode.strip_height = 3;
+    addMode(CPPN_NETWORK, "strips", METHOD_STRIPS, config_mode, 0, 0.0);
+    config_mode.batch_evaluation = true;
+    config_mode.separable_evaluation = true;
+    addMode(CPPN_NETWORK, "strips_batch_separable", METHOD_STRIPS, config_mode, 0, 0.0);
+    addMode(CPPN_NETWORK, "render_cache", METHOD_RENDER_CACHE, base, 0, 0.0);
+
+    // The error sums are integers, so the fused fitness has to be identical to the error of the reference
+    addMode(CPPN_NETWORK, "fitness", METHOD_FITNESS, base, 0, 0.0);
+    config_mode = base;
+    config_mode.batch_evaluation = true;
+    config_mode.separable_evaluation = true;
+    addMode(CPPN_NETWORK, "fitness_batch_separable", METHOD_FITNESS, config_mode, 0, 0.0);
+    config_mode = base;
+    config_mode.parallel_rendering = true;
+    config_mode.band_height = 7;
+    addMode(CPPN_NETWORK, "fitness_parallel", METHOD_FITNESS, config_mode, 0, 0.0);
+    config_mode = base;
+    config_mode.band_height = 2;
+    addMode(CPPN_NETWORK, "fitness_threshold", METHOD_FITNESS_THRESHOLD, config_mode, 0, 0.0);
+    if(_config.kernel_compiler != NULL)
+    {
+        config_mode = base;
+        config_mode.kernel_compiler = _config.kernel_compiler;
+        addMode(CPPN_NETWORK, "native_kernel", METHOD_NETWORK, config_mode, 0, 0.0);
+    }
+
+    // The approximations only change a channel if its reference value lies directly at a quantisation step
+    config_mode = base;
+    config_mode.accuracy = CPPNProgram::ACCURACY_APPROXIMATE;
+    addMode(CPPN_NETWORK, "approximate", METHOD_NETWORK, config_mode, 1, 1e-4);
+    config_mode.batch_evaluation = true;
+    addMode(CPPN_NETWORK, "approximate_batch", METHOD_NETWORK, config_mode, 1, 1e-4);
+
+    // Float differs by one step for a few pixels, networks amplifying large sums can differ by some steps
+    config_mode = base;
+    config_mode.precision = ImageCPPNGeneratorNetwork::PRECISION_FLOAT;
+    addMode(CPPN_NETWORK, "float", METHOD_NETWORK, config_mode, 8, 2e-3);
+    config_mode.batch_evaluation = true;
+    addMode(CPPN_NETWORK, "float_batch", METHOD_NETWORK, config_mode, 8, 2e-3);
+    config_mode.separable_evaluation = true;
+    addMode(CPPN_NETWORK, "float_batch_separable", METHOD_NETWORK, config_mode, 8, 2e-3);
+    config_mode.separable_evaluation = false;
+    config_mode.accuracy = CPPNProgram::ACCURACY_APPROXIMATE;
+    addMode(CPPN_NETWORK, "float_approximate_batch", METHOD_NETWORK, config_mode, 8, 2e-3);
+    if(_config.kernel_compiler != NULL)
+    {
+        config_mode = base;
+        config_mode.precision = ImageCPPNGeneratorNetwork::PRECISION_FLOAT;
+        config_mode.kernel_compiler = _config.kernel_compiler;
+        addMode(CPPN_NETWORK, "native_kernel_float", METHOD_NETWORK, config_mode, 8, 2e-3);
+    }
+
+    addMode(ANIMATION_NETWORK, "frames", METHOD_ANIMATION, base, 0, 0.0);
+    config_mode = base;
+    config_mode.batch_evaluation = true;
+    addMode(ANIMATION_NETWORK, "frames_batch", METHOD_ANIMATION, config_mode, 0, 0.0);
+    config_mode = base;
+    config_mode.separable_evaluation = true;
+    addMode(ANIMATION_NETWORK, "frames_separable", METHOD_ANIMATION, config_mode, 0, 0.0);
+    config_mode.batch_evaluation = true;
+    addMode(ANIMATION_NETWORK, "frames_batch_separable", METHOD_ANIMATION, config_mode, 0, 0.0);
+    if(_config.kernel_compiler != NULL)
+    {
+        config_mode = base;
+        config_mode.kernel_compiler = _config.kernel_compiler;
+        addMode(ANIMATION_NETWORK, "native_kernel", METHOD_ANIMATION, config_mode, 0, 0.0);
+    }
+    config_mode = base;
+    config_mode.precision = ImageCPPNGeneratorNetwork::PRECISION_FLOAT;
+    addMode(ANIMATION_NETWORK, "frames_float", METHOD_ANIMATION, config_mode, 8, 2e-3);
+    config_mode.separable_evaluation = true;
+    addMode(ANIMATION_NETWORK, "frames_float_separable", METHOD_ANIMATION, config_mode, 8, 2e-3);
+
+    addMode(DIRECT_ENCODING_NETWORK, "segments", METHOD_DIRECT_SEGMENTS, base, 0, 0.0);
+    addMode(DIRECT_ENCODING_NETWORK, "buffer", METHOD_DIRECT_BUFFER, base, 0, 0.0);
+    addMode(DIRECT_ENCODING_NETWORK, "snapshot", METHOD_DIRECT_SNAPSHOT, base, 0, 0.0);
+}
+
+bool DifferentialHarness::run(QTextStream &stream)
+{
+    stream << "network,mode,genomes,pixels,max_channel_difference,mismatched_pixel_fraction,worst_genome_mismatched_fraction,max_channel_difference_tolerance,mismatched_pixel_fraction_tolerance,result" << endl;
+    bool passed = true;
+
+    QStringList networks;
+    if(_config.cppn)
+    {
+        networks << CPPN_NETWORK;
+    }
+    if(_config.direct_encoding)
+    {
+        networks << DIRECT_ENCODING_NETWORK;
+    }
+    if(_config.animation)
+    {
+        networks << ANIMATION_NETWORK;
+    }
+
+    foreach(QString network, networks)
+    {
+        QVector<sample> samples = createSamples(network);
+        QVector<qint32> indices(samples.size());
+        for(qint32 i = 0; i < indices.size(); ++i)
+        {
+            indices[i] = i;
+        }
+
+        for(qint32 m = 0; m < _modes.size(); ++m)
+        {
+            mode &mode = _modes[m];
+            if(mode.network != network)
+            {
+                continue;
+            }
+
+            QVector<difference> differences(samples.size());
+            QtConcurrent::blockingMap(indices, [this, &mode, &samples, &differences](qint32 &i)
+            {
+                differences[i] = check(mode, samples[i], i);
+            });
+
+            for(qint32 i = 0; i < samples.size(); ++i)
+            {
+                qint64 pixels = differences[i].pixels;
+                ++mode.genomes;
+                mode.pixels += pixels;
+                mode.mismatched_pixels += differences[i].mismatched_pixels;
+                mode.max_difference = qMax(mode.max_difference, differences[i].max_difference);
+                mode.worst_genome_mismatch = qMax(mode.worst_genome_mismatch, differences[i].mismatched_pixels / (double) pixels);
+            }
+
+            double mismatch = mode.pixels > 0 ? mode.mismatched_pixels / (double) mode.pixels : 0.0;
+            bool mode_passed = mode.max_difference <= mode.max_difference_tolerance && mismatch <= mode.mismatch_tolerance;
+            passed &= mode_passed;
+            stream << mode.network << ","
+                   << mode.name << ","
+                   << mode.genomes << ","
+                   << mode.pixels << ","
+                   << mode.max_difference << ","
+                   << QString::number(mismatch, 'g', 6) << ","
+                   << QString::number(mode.worst_genome_mismatch, 'g', 6) << ","
+                   << mode.max_difference_tolerance << ","
+                   << QString::number(mode.mismatch_tolerance, 'g', 6) << ","
+                   << (mode_passed ? "pass" : "fail") << endl;
+        }
+
+        foreach(const sample &sample, samples)
+        {
+            delete sample.gene;
+            delete sample.buffer_gene;
+        }
+    }
+    return passed;
+}
+
+QImage DifferentialHarness::referenceCPPN(GenericGene *gene, qint32 width, qint32 height, qint32 inputs, double time)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    qint32 x_center = width / 2;
+    qint32 y_center = height / 2;
+    double max_distance = qSqrt(qPow(width, 2) + qPow(height, 2))/2;
+    qint32 neurons = inputs + gene->segments().size();
+    QVector<double> network(neurons);
+
+    for(qint32 x = 0; x < width; ++x)
+    {
+        for(qint32 y = 0; y < height; ++y)
+        {
+            double distance_to_center = qSqrt(qPow(x - x_center, 2) + qPow(y - y_center, 2)) / max_distance;
+            network[0] = 1.0;
+            network[1] = (qreal) x / (qreal) width;
+            network[2] = (qreal) y / (qreal) height;
+            network[3] = distance_to_center;
+            if(inputs > ImageCPPNGeneratorNetwork::INPUT_NEURONS)
+            {
+                network[CPPNProgram::TIME_INPUT] = time;
+            }
+            for(qint32 neuron = 0; neuron < gene->segments().size(); ++neuron)
+            {
+                double value = 0.0;
+                for(qint32 input = 0; input < neuron + inputs; ++input)
+                {
+                    if(weight(gene->segments()[neuron][1 + (2 * input)], 1) > 0)
+                    {
+                        value += network[input] * weight(gene->segments()[neuron][1 + (2 * input) + 1], 1);
+                    }
+                }
+                network[inputs + neuron] = referenceFunction(value, gene->segments()[neuron][0]);
+            }
+            qint32 r = qFloor(qBound(0.0, network[neurons - 3] * 255, 255.0));
+            qint32 g = qFloor(qBound(0.0, network[neurons - 2] * 255, 255.0));
+            qint32 b = qFloor(qBound(0.0, network[neurons - 1] * 255, 255.0));
+            image.setPixel(x, y, qRgb(r, g, b));
+        }
+    }
+    return image;
+}
+
+QImage DifferentialHarness::referenceDirectEncoding(GenericGene *gene, qint32 width, qint32 height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+
+    for(qint32 y = 0; y < height; ++y)
+    {
+        for(qint32 x = 0; x < width; ++x)
+        {
+            qint32 r = qFloor(floatFromGeneInput(gene->segments()[width * y + x][0], 255));
+            qint32 g = qFloor(floatFromGeneInput(gene->segments()[width * y + x][1], 255));
+            qint32 b = qFloor(floatFromGeneInput(gene->segments()[width * y + x][2], 255));
+            image.setPixel(x, y, qRgb(r, g, b));
+        }
+    }
+    return image;
+}
+
+void DifferentialHarness::addMode(QString network, QString name, render_method method, ImageCPPNGeneratorNetwork::config cppn_config, qint32 max_difference_tolerance, double mismatch_tolerance)
+{
+    mode mode;
+    mode.network = network;
+    mode.name = name;
+    mode.method = method;
+    mode.cppn_config = cppn_config;
+    mode.max_difference_tolerance = max_difference_tolerance;
+    mode.mismatch_tolerance = mismatch_tolerance;
+    mode.genomes = 0;
+    mode.pixels = 0;
+    mode.mismatched_pixels = 0;
+    mode.max_difference = 0;
+    mode.worst_genome_mismatch = 0.0;
+    _modes.append(mode);
+}
+
+DifferentialHarness::difference DifferentialHarness::check(const mode &mode, const sample &sample, qint32 index)
+{
+    switch(mode.method)
+    {
+    case METHOD_FITNESS:
+    case METHOD_FITNESS_THRESHOLD:
+        return checkFitness(mode, sample);
+    case METHOD_DIRECT_BUFFER:
+    case METHOD_DIRECT_SNAPSHOT:
+        return compare(sample.buffer_reference, render(mode, sample, index));
+    default:
+        return compare(sample.reference, render(mode, sample, index));
+    }
+}
+
+DifferentialHarness::difference DifferentialHarness::checkFitness(const mode &mode, const sample &sample)
+{
+    ImageTargetFitness target(sample.target);
+    qint64 error = 0;
+    for(qint32 y = 0; y < sample.reference.height(); ++y)
+    {
+        error += target.error(reinterpret_cast<const QRgb *>(sample.reference.constScanLine(y)), y, 1);
+    }
+    double expected = target.normalisedError(error);
+
+    ImageCPPNGeneratorNetwork::config cppn_config = mode.cppn_config;
+    cppn_config.width = sample.size.width();
+    cppn_config.height = sample.size.height();
+    cppn_config.min_size = sample.range.min_size;
+    cppn_config.max_size = sample.range.max_size;
+    cppn_config.target_fitness = &target;
+    if(mode.method == METHOD_FITNESS_THRESHOLD)
+    {
+        // Half of the error stops the evaluation early unless the image is identical to the target
+        cppn_config.fitness_threshold = expected / 2.0;
+    }
+    ImageCPPNGeneratorNetwork network(0, 0, cppn_config);
+    network.initialise(new GenericGene(sample.gene->segments(), sample.gene->segmentSize()));
+    network.processInput(QList<double>());
+
+    // After an early stop the fitness is a lower bound of the error which exceeds the threshold
+    bool exceeded = expected > cppn_config.fitness_threshold;
+    bool matches = network.fitnessThresholdExceeded() == exceeded;
+    if(exceeded)
+    {
+        matches &= network.fitness() > cppn_config.fitness_threshold && network.fitness() <= expected;
+    }
+    else
+    {
+        matches &= network.fitness() == expected;
+    }
+
+    difference result;
+    result.pixels = (qint64) sample.size.width() * sample.size.height();
+    result.mismatched_pixels = matches ? 0 : result.pixels;
+    result.max_difference = matches ? 0 : qBound(1, qCeil(qAbs(network.fitness() - expected) * 255), 255);
+    return result;
+}
+
+QImage DifferentialHarness::render(const mode &mode, const sample &sample, qint32 index)
+{
+    qint32 width = sample.size.width();
+    qint32 height = sample.size.height();
+    ImageCPPNGeneratorNetwork::config cppn_config = mode.cppn_config;
+    cppn_config.width = width;
+    cppn_config.height = height;
+    cppn_config.min_size = sample.range.min_size;
+    cppn_config.max_size = sample.range.max_size;
+    ImageDirectEncodingGeneratorNetwork::config direct_config;
+    direct_config.width = width;
+    direct_config.height = height;
+    direct_config.save_image = false;
+
+    // The snapshots are loaded in place, so they need memory aligned to 8 bytes
+    QVector<quint64> memory;
+    GeneratorSnapshot snapshot;
+    QByteArray data;
+
+    switch(mode.method)
+    {
+    case METHOD_NETWORK:
+    {
+        ImageCPPNGeneratorNetwork network(0, 0, cppn_config);
+        network.initialise(new GenericGene(sample.gene->segments(), sample.gene->segmentSize()));
+        network.processInput(QList<double>());
+        return network.getImage();
+    }
+    case METHOD_POPULATION:
+    {
+        QList<GenericGene *> genes;
+        genes.append(sample.gene);
+        return ImageCPPNGeneratorNetwork::renderPopulation(genes, cppn_config)[0];
+    }
+    case METHOD_STRIPS:
+    {
+        cppn_config.save_image = true;
+        cppn_config.image_path = _directory.filePath(QString("%1.ppm").arg(index));
+        ImageCPPNGeneratorNetwork network(0, 0, cppn_config);
+        network.initialise(new GenericGene(sample.gene->segments(), sample.gene->segmentSize()));
+        network.processInput(QList<double>());
+        QImage image = readPPM(cppn_config.image_path, width, height);
+        QFile::remove(cppn_config.image_path);
+        return image;
+    }
+    case METHOD_RENDER_CACHE:
+    {
+        // The second network has to take the image rendered by the first one from the cache
+        ImageRenderCache cache;
+        cppn_config.render_cache = &cache;
+        QImage image;
+        for(qint32 i = 0; i < 2; ++i)
+        {
+            ImageCPPNGeneratorNetwork network(0, 0, cppn_config);
+            network.initialise(new GenericGene(sample.gene->segments(), sample.gene->segmentSize()));
+            network.processInput(QList<double>());
+            image = network.getImage();
+        }
+        return cache.hits() == 1 ? image : QImage();
+    }
+    case METHOD_ANIMATION:
+    {
+        ImageCPPNAnimationNetwork::config animation_config;
+        static_cast<ImageCPPNGeneratorNetwork::config &>(animation_config) = cppn_config;
+        animation_config.frames = ANIMATION_FRAMES;
+        ImageCPPNAnimationNetwork network(0, 0, animation_config);
+        network.initialise(new GenericGene(sample.gene->segments(), sample.gene->segmentSize()));
+        network.processInput(QList<double>());
+        return stackFrames(network.getFrames());
+    }
+    case METHOD_SNAPSHOT:
+    {
+        CPPNProgram program;
+        program.decode(sample.gene->segments(), ImageCPPNGeneratorNetwork::INPUT_NEURONS, cppn_config.accuracy);
+        data = GeneratorSnapshot::fromCPPN(program, cppn_config);
+        break;
+    }
+    case METHOD_DIRECT_SEGMENTS:
+    {
+        ImageDirectEncodingGeneratorNetwork network(0, 0, direct_config);
+        network.initialise(new GenericGene(sample.gene->segments(), sample.gene->segmentSize()));
+        network.processInput(QList<double>());
+        return network.getImage();
+    }
+    case METHOD_DIRECT_BUFFER:
+    {
+        ImageDirectEncodingGeneratorNetwork network(0, 0, direct_config);
+        network.initialise(new RGBBufferGene(sample.buffer_gene->buffer()));
+        network.processInput(QList<double>());
+        return network.getImage();
+    }
+    case METHOD_DIRECT_SNAPSHOT:
+    {
+        data = GeneratorSnapshot::fromDirectEncoding(reinterpret_cast<const uchar *>(sample.buffer_gene->buffer().constData()), width, height, direct_config);
+        break;
+    }
+    default:
+        QNN_CRITICAL_MSG("Unknown render method");
+        return QImage();
+    }
+
+    memory.resize((data.size() + 7) / 8);
+    memcpy(memory.data(), data.constData(), data.size());
+    if(!snapshot.load(reinterpret_cast<const uchar *>(memory.constData()), data.size()))
+    {
+        return QImage();
+    }
+    // A direct encoding image uses the memory of the snapshot, so it is converted before the memory is released
+    return snapshot.image().convertToFormat(QImage::Format_RGB32);
+}
+
+QImage DifferentialHarness::readPPM(const QString &path, qint32 width, qint32 height)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        return QImage();
+    }
+    QByteArray data = file.readAll();
+    QByteArray header = QString("P6\n%1 %2\n255\n").arg(width).arg(height).toLatin1();
+    if(!data.startsWith(header) || data.size() != header.size() + width * height * 3)
+    {
+        return QImage();
+    }
+
+    QImage image(width, height, QImage::Format_RGB32);
+    const uchar *rgb = reinterpret_cast<const uchar *>(data.constData()) + header.size();
+    for(qint32 y = 0; y < height; ++y)
+    {
+        for(qint32 x = 0; x < width; ++x)
+        {
+            image.setPixel(x, y, qRgb(rgb[0], rgb[1], rgb[2]));
+            rgb += 3;
+        }
+    }
+    return image;
+}
+
+QImage DifferentialHarness::stackFrames(const QList<QImage> &frames)
+{
+    if(frames.isEmpty())
+    {
+        return QImage();
+    }
+
+    qint32 width = frames.first().width();
+    qint32 height = frames.first().height();
+    QImage image(width, height * frames.size(), QImage::Format_RGB32);
+    for(qint32 frame = 0; frame < frames.size(); ++frame)
+    {
+        for(qint32 y = 0; y < height; ++y)
+        {
+            for(qint32 x = 0; x < width; ++x)
+            {
+                image.setPixel(x, frame * height + y, frames[frame].pixel(x, y));
+            }
+        }
+    }
+    return image;
+}
+
+DifferentialHarness::difference DifferentialHarness::compare(const QImage &reference, const QImage &image)
+{
+    difference result;
+    result.pixels = (qint64) reference.width() * reference.height();
+    if(image.width() != reference.width() || image.height() != reference.height())
+    {
+        result.mismatched_pixels = result.pixels;
+        result.max_difference = 255;
+        return result;
+    }
+
+    result.mismatched_pixels = 0;
+    result.max_difference = 0;
+    for(qint32 y = 0; y < reference.height(); ++y)
+    {
+        for(qint32 x = 0; x < reference.width(); ++x)
+        {
+            QRgb expected = reference.pixel(x, y);
+            QRgb actual = image.pixel(x, y);
+            qint32 difference = qMax(qAbs(qRed(expected) - qRed(actual)), qMax(qAbs(qGreen(expected) - qGreen(actual)), qAbs(qBlue(expected) - qBlue(actual))));
+            if(difference > 0)
+            {
+                ++result.mismatched_pixels;
+                result.max_difference = qMax(result.max_difference, difference);
+            }
+        }
+    }
+    return result;
+}
+
+QVector<DifferentialHarness::sample> DifferentialHarness::createSamples(const QString &network)
+{
+    QVector<sample> samples;
+    foreach(QSize size, _config.sizes)
+    {
+        qint32 pixels = size.width() * size.height();
+        if(network == DIRECT_ENCODING_NETWORK)
+        {
+            ImageDirectEncodingGeneratorNetwork::config config;
+            config.width = size.width();
+            config.height = size.height();
+            config.save_image = false;
+            config.buffer_gene = true;
+            ImageDirectEncodingGeneratorNetwork factory(0, 0, config);
+            for(qint32 i = 0; i < _config.genomes; ++i)
+            {
+                sample sample;
+                sample.gene = new GenericGene(pixels, 3);
+                sample.size = size;
+                sample.range.min_size = 0;
+                sample.range.max_size = 0;
+                sample.reference = referenceDirectEncoding(sample.gene, size.width(), size.height());
+                sample.buffer_gene = static_cast<RGBBufferGene *>(factory.getRandomGene());
+
+                // Every channel is the middle of the gene values which the reference decodes to the byte of the buffer
+                const uchar *rgb = reinterpret_cast<const uchar *>(sample.buffer_gene->buffer().constData());
+                QList< QList<qint32> > segments;
+                for(qint32 pixel = 0; pixel < pixels; ++pixel)
+                {
+                    QList<qint32> segment;
+                    for(qint32 channel = 0; channel < 3; ++channel)
+                    {
+                        double value = (rgb[pixel * 3 + channel] + 0.5) / 255.0 * std::numeric_limits<qint32>::max();
+                        segment.append((qint32) qMin(value, (double) std::numeric_limits<qint32>::max()));
+                    }
+                    segments.append(segment);
+                }
+                GenericGene equivalent(segments, 3);
+                sample.buffer_reference = referenceDirectEncoding(&equivalent, size.width(), size.height());
+                samples.append(sample);
+            }
+            continue;
+        }
+
+        foreach(neuron_range range, _config.neuron_ranges)
+        {
+            ImageCPPNAnimationNetwork::config config;
+            config.width = size.width();
+            config.height = size.height();
+            config.min_size = range.min_size;
+            config.max_size = range.max_size;
+            config.save_image = false;
+            ImageCPPNGeneratorNetwork cppn_factory(0, 0, config);
+            ImageCPPNAnimationNetwork animation_factory(0, 0, config);
+            for(qint32 i = 0; i < _config.genomes; ++i)
+            {
+                sample sample;
+                sample.gene = network == ANIMATION_NETWORK ? animation_factory.getRandomGene() : cppn_factory.getRandomGene();
+                sample.size = size;
+                sample.range = range;
+                sample.buffer_gene = NULL;
+                if(network == CPPN_NETWORK)
+                {
+                    GenericGene target(pixels, 3);
+                    sample.target = referenceDirectEncoding(&target, size.width(), size.height());
+                }
+                samples.append(sample);
+            }
+        }
+    }
+
+    // The reference is slow, so it is calculated in parallel as well
+    bool animation = network == ANIMATION_NETWORK;
+    QtConcurrent::blockingMap(samples, [animation](sample &sample)
+    {
+        if(!sample.reference.isNull())
+        {
+            return;
+        }
+        if(!animation)
+        {
+            sample.reference = referenceCPPN(sample.gene, sample.size.width(), sample.size.height());
+            return;
+        }
+        QList<QImage> frames;
+        for(qint32 frame = 0; frame < ANIMATION_FRAMES; ++frame)
+        {
+            // The time runs from -1 in the first frame to 1 in the last frame
+            double time = -1.0 + 2.0 * frame / (ANIMATION_FRAMES - 1);
+            frames.append(referenceCPPN(sample.gene, sample.size.width(), sample.size.height(), ImageCPPNAnimationNetwork::INPUT_NEURONS, time));
+        }
+        sample.reference = stackFrames(frames);
+    });
+    return samples;
+}
+
+double DifferentialHarness::referenceFunction(double value, qint32 geneValue)
+{
+    switch(qFloor(floatFromGeneInput(geneValue, 6)))
+    {
+    case 0:
+        return qCos(value);
+        break;
+    case 1:
+        return qSin(value);
+        break;
+    case 2:
+        return tanh(value);
+        break;
+    case 3:
+        // Identity between 0,1
+        return qBound(0.0, value, 1.0);
+        break;
+    case 4:
+        return qExp(-1 * (qPow(value, 2)) / 0.5);
+        break;
+    case 5:
+    case 6: // 6 is an extreme corner case which should almost never occure
+        return sigmoid(value);
+        break;
+    default:
+        QNN_CRITICAL_MSG("Unknown function" << qFloor(floatFromGeneInput(geneValue, 5)));
+        return value;
+    }
+}
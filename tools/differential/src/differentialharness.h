@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DIFFERENTIALHARNESS_H
+#define DIFFERENTIALHARNESS_H
+
+#include <network/imagecppngeneratornetwork.h>
+#include <network/imagecppnanimationnetwork.h>
+#include <network/imagedirectencodinggeneratornetwork.h>
+#include <network/cppnactivationcache.h>
+#include <network/cppnkernelcompiler.h>
+#include <network/genericgene.h>
+#include <network/rgbbuffergene.h>
+
+#include <QList>
+#include <QVector>
+#include <QSize>
+#include <QString>
+#include <QImage>
+#include <QTextStream>
+#include <QTemporaryDir>
+
+/*!
+ * \brief The DifferentialHarness class compares all rendering paths of the generator networks with a reference implementation.
+ *
+ * The reference is the scalar pixel by pixel evaluation of the gene which ImageCPPNGeneratorNetwork and ImageDirectEncodingGeneratorNetwork
+ * used before the rendering was optimised (see referenceCPPN() and referenceDirectEncoding()). It does not use any code of the optimised paths.
+ * The frames of ImageCPPNAnimationNetwork are compared with the same reference, with the time of the frame as fifth input.
+ *
+ * For every range of hidden neurons and every image size, genomes random genes are created with getRandomGene() and every gene is
+ * rendered with every mode (e.g. batch_evaluation, PRECISION_FLOAT, ACCURACY_APPROXIMATE, parallel_rendering, renderPopulation(),
+ * snapshots, strip_height, render_cache). Every mode has a tolerance for the maximum difference of a channel and for the fraction of
+ * mismatched pixels. Exact modes must be identical to the reference. Modes with float precision or approximate activation functions may differ slightly.
+ *
+ * The fitness modes evaluate the gene with target_fitness against a random target and compare fitness() with the error of the reference image.
+ * If the fitness differs, all pixels of the gene count as mismatched and the maximum difference is the difference of the fitness scaled to 0 to 255.
+ * The direct encoding genes of the buffer mode are created independently with RGBBufferGene and compared with the reference of a segment gene
+ * with the same colors.
+ *
+ * The results are written as CSV. Every mode is written as one line with the columns
+ * network, mode, genomes, pixels, max_channel_difference, mismatched_pixel_fraction, worst_genome_mismatched_fraction,
+ * max_channel_difference_tolerance, mismatched_pixel_fraction_tolerance, result.
+ * mismatched_pixel_fraction is the fraction of all compared pixels of the mode with at least one differing channel,
+ * result is "pass" if both values are within the tolerances of the mode and "fail" otherwise.
+ */
+
+class DifferentialHarness
+{
+public:
+    /*!
+     * \brief A range of hidden neurons
+     */
+    struct neuron_range {
+        /*!
+         * \brief ImageCPPNGeneratorNetwork::config::min_size
+         */
+        qint32 min_size;
+
+        /*!
+         * \brief ImageCPPNGeneratorNetwork::config::max_size. Must be greater than min_size
+         */
+        qint32 max_size;
+    };
+
+    /*!
+     * \brief This struct contains all configuration option of the harness
+     */
+    struct config {
+        /*!
+         * \brief Ranges of hidden neurons of the random CPPN genes
+         */
+        QList<neuron_range> neuron_ranges;
+
+        /*!
+         * \brief Image sizes to compare
+         */
+        QList<QSize> sizes;
+
+        /*!
+         * \brief Number of random genes per neuron range and image size
+         */
+        qint32 genomes;
+
+        /*!
+         * \brief If true ImageCPPNGeneratorNetwork is compared
+         */
+        bool cppn;
+
+        /*!
+         * \brief If true ImageDirectEncodingGeneratorNetwork is compared
+         */
+        bool direct_encoding;
+
+        /*!
+         * \brief If true ImageCPPNAnimationNetwork is compared
+         *
+         * Every gene is rendered with ANIMATION_FRAMES frames, so the genes take about three times as long as CPPN genes.
+         */
+        bool animation;
+
+        /*!
+         * \brief Compiler for the native kernel modes. NULL skips these modes
+         *
+         * Every gene is compiled, so this takes a few hundred milliseconds per gene. If the compiler fails, the network falls back to the
+         * decoded program and the mode compares the fallback.
+         */
+        CPPNKernelCompiler *kernel_compiler;
+
+        /*!
+         * \brief Constructor for standard values
+         */
+        config() :
+            neuron_ranges(),
+            sizes(),
+            genomes(100),
+            cppn(true),
+            direct_encoding(true),
+            animation(true),
+            kernel_compiler(NULL)
+        {
+            neuron_range range;
+            range.min_size = 0;
+            range.max_size = 5;
+            neuron_ranges << range;
+            range.min_size = 5;
+            range.max_size = 10;
+            neuron_ranges << range;
+            range.min_size = 10;
+            range.max_size = 20;
+            neuron_ranges << range;
+            range.min_size = 20;
+            range.max_size = 30;
+            neuron_ranges << range;
+            sizes << QSize(1, 1) << QSize(7, 5) << QSize(16, 16) << QSize(33, 17) << QSize(64, 64);
+        }
+    };
+
+    /*!
+     * \brief Constructor
+     * \param config Configuration of the harness
+     */
+    DifferentialHarness(config config = config());
+
+    /*!
+     * \brief Compares all modes with the reference
+     * \param stream Stream the CSV lines are written to
+     * \return True if all modes are within their tolerances
+     */
+    bool run(QTextStream &stream);
+
+    /*!
+     * \brief Number of frames of the compared animations
+     */
+    static const qint32 ANIMATION_FRAMES = 3;
+
+    /*!
+     * \brief Renders a CPPN gene with the reference implementation
+     *
+     * This is the pixel wise evaluation of the gene used by ImageCPPNGeneratorNetwork before the gene was decoded into a CPPNProgram.
+     *
+     * \param gene CPPN gene
+     * \param width Width of the image in pixel
+     * \param height Height of the image in pixel
+     * \param inputs Number of input neurons. ImageCPPNAnimationNetwork::INPUT_NEURONS adds the time as fifth input
+     * \param time Value of the time input
+     * \return Image in Format_RGB32
+     */
+    static QImage referenceCPPN(GenericGene *gene, qint32 width, qint32 height, qint32 inputs = ImageCPPNGeneratorNetwork::INPUT_NEURONS, double time = 0.0);
+
+    /*!
+     * \brief Renders a direct encoding gene made of segments with the reference implementation
+     * \param gene Gene with one segment of size 3 per pixel
+     * \param width Width of the image in pixel
+     * \param height Height of the image in pixel
+     * \return Image in Format_RGB32
+     */
+    static QImage referenceDirectEncoding(GenericGene *gene, qint32 width, qint32 height);
+
+private:
+    /*!
+     * \brief How a mode renders the gene
+     */
+    enum render_method {
+        METHOD_NETWORK,
+        METHOD_POPULATION,
+        METHOD_SNAPSHOT,
+        METHOD_STRIPS,
+        METHOD_RENDER_CACHE,
+        METHOD_FITNESS,
+        METHOD_FITNESS_THRESHOLD,
+        METHOD_ANIMATION,
+        METHOD_DIRECT_SEGMENTS,
+        METHOD_DIRECT_BUFFER,
+        METHOD_DIRECT_SNAPSHOT
+    };
+
+    /*!
+     * \brief A compared mode and the accumulated differences
+     */
+    struct mode {
+        QString network;
+        QString name;
+        render_method method;
+        ImageCPPNGeneratorNetwork::config cppn_config;
+        qint32 max_difference_tolerance;
+        double mismatch_tolerance;
+        qint64 genomes;
+        qint64 pixels;
+        qint64 mismatched_pixels;
+        qint32 max_difference;
+        double worst_genome_mismatch;
+    };
+
+    /*!
+     * \brief A random gene with its reference image
+     *
+     * The reference of an animation contains all frames one below the other.
+     * target is only set for CPPN genes, buffer_gene and buffer_reference only for direct encoding genes.
+     */
+    struct sample {
+        GenericGene *gene;
+        QSize size;
+        neuron_range range;
+        QImage reference;
+        QImage target;
+        RGBBufferGene *buffer_gene;
+        QImage buffer_reference;
+    };
+
+    /*!
+     * \brief Name of the CPPN network in the results
+     */
+    static const char *CPPN_NETWORK;
+
+    /*!
+     * \brief Name of the direct encoding network in the results
+     */
+    static const char *DIRECT_ENCODING_NETWORK;
+
+    /*!
+     * \brief Name of the animation network in the results
+     */
+    static const char *ANIMATION_NETWORK;
+
+    /*!
+     * \brief Adds a mode
+     * \param network Name of the network
+     * \param name Name of the mode
+     * \param method How the gene is rendered
+     * \param cppn_config Options of the CPPN network. Size and neuron range are set for every gene
+     * \param max_difference_tolerance Tolerance of the maximum difference of a channel
+     * \param mismatch_tolerance Tolerance of the fraction of mismatched pixels
+     */
+    void addMode(QString network, QString name, render_method method, ImageCPPNGeneratorNetwork::config cppn_config, qint32 max_difference_tolerance, double mismatch_tolerance);
+
+    /*!
+     * \brief Differences of one image
+     */
+    struct difference {
+        qint64 pixels;
+        qint64 mismatched_pixels;
+        qint32 max_difference;
+    };
+
+    /*!
+     * \brief Renders a gene with a mode and compares the result with its reference
+     *
+     * Thread safe, the genes are checked in parallel.
+     *
+     * \param mode Mode
+     * \param sample Gene
+     * \param index Index of the gene, used to name its files
+     * \return Differences to the reference
+     */
+    difference check(const mode &mode, const sample &sample, qint32 index);
+
+    /*!
+     * \brief Evaluates the fitness of a CPPN gene and compares it with the error of the reference
+     * \param mode Mode with METHOD_FITNESS or METHOD_FITNESS_THRESHOLD
+     * \param sample Gene
+     * \return Differences to the reference
+     */
+    difference checkFitness(const mode &mode, const sample &sample);
+
+    /*!
+     * \brief Renders a gene with a mode
+     *
+     * Thread safe, the genes are rendered in parallel.
+     *
+     * \param mode Mode
+     * \param sample Gene
+     * \param index Index of the gene, used to name its files
+     * \return Rendered image
+     */
+    QImage render(const mode &mode, const sample &sample, qint32 index);
+
+    /*!
+     * \brief Reads a binary PPM written by PPMStripWriter
+     * \param path Path of the file
+     * \param width Expected width in pixel
+     * \param height Expected height in pixel
+     * \return Image in Format_RGB32. A null image if the file can not be read or the header does not match
+     */
+    static QImage readPPM(const QString &path, qint32 width, qint32 height);
+
+    /*!
+     * \brief Places frames one below the other
+     * \param frames Frames of the same size
+     * \return Image in Format_RGB32
+     */
+    static QImage stackFrames(const QList<QImage> &frames);
+
+    /*!
+     * \brief Compares an image with the reference
+     * \param reference Reference image
+     * \param image Rendered image
+     * \return Number of mismatched pixels and maximum difference of a channel. All pixels mismatch if the size differs
+     */
+    static difference compare(const QImage &reference, const QImage &image);
+
+    /*!
+     * \brief Creates the random genes and their reference images
+     *
+     * CPPN and animation genes are created with getRandomGene() of their network for every neuron range and image size.
+     * CPPN genes get a random target for the fitness modes.
+     * Direct encoding genes are made of random segments for every image size. Additionally a random RGBBufferGene is created with
+     * ImageDirectEncodingGeneratorNetwork::config::buffer_gene, whose reference is rendered from a segment gene with the same colors.
+     *
+     * \param network CPPN_NETWORK, ANIMATION_NETWORK or DIRECT_ENCODING_NETWORK
+     * \return Genes. The caller must delete the genes
+     */
+    QVector<sample> createSamples(const QString &network);
+
+    /*!
+     * \brief Applies an activation function like the reference implementation
+     * \param value The internal value of the neuron
+     * \param geneValue The gene value
+     * \return value with applied activation function
+     */
+    static double referenceFunction(double value, qint32 geneValue);
+
+    config _config;
+    CPPNActivationCache _activation_cache;
+    QList<mode> _modes;
+
+    /*!
+     * \brief Directory of the images streamed by the strip modes
+     */
+    QTemporaryDir _directory;
+};
+
+#endif // DIFFERENTIALHARNESS_H
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2015 Marcus Soll
+ * This file is part of qnn-image-generators.
+ *
+ * qnn-image-generators is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * qnn-image-generators is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with qnn-image-generators.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "differentialharness.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("qnn-image-generators-differential");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders random genomes through every rendering path of ImageCPPNGeneratorNetwork, ImageCPPNAnimationNetwork and ImageDirectEncodingGeneratorNetwork "
+                                     "and compares the images with a scalar reference implementation. The result of every path is written as CSV. "
+                                     "Returns 1 if a path exceeds its tolerance.");
+    parser.addHelpOption();
+
+    QCommandLineOption neurons_option("neurons", "Comma separated list of ranges of hidden neurons (min-max).", "ranges", "0-5,5-10,10-20,20-30");
+    QCommandLineOption sizes_option("sizes", "Comma separated list of image sizes (widthxheight).", "sizes", "1x1,7x5,16x16,33x17,64x64");
+    QCommandLineOption genomes_option("genomes", "Number of genomes per range and size.", "count", "100");
+    QCommandLineOption network_option("network", "Network to test (all, cppn, direct, animation).", "network", "all");
+    QCommandLineOption kernel_option("native-kernels", "Also test native kernels of the CPPN.");
+    QCommandLineOption output_option("output", "Write the results to file instead of stdout.", "file");
+
+    parser.addOption(neurons_option);
+    parser.addOption(sizes_option);
+    parser.addOption(genomes_option);
+    parser.addOption(network_option);
+    parser.addOption(kernel_option);
+    parser.addOption(output_option);
+    parser.process(a);
+
+    DifferentialHarness::config config;
+    bool ok = true;
+    bool all_ok = true;
+
+    config.neuron_ranges.clear();
+    foreach(QString range, parser.value(neurons_option).split(",", QString::SkipEmptyParts))
+    {
+        QStringList values = range.split("-");
+        DifferentialHarness::neuron_range neuron_range;
+        all_ok &= values.size() == 2;
+        if(values.size() == 2)
+        {
+            neuron_range.min_size = values[0].toInt(&ok);
+            all_ok &= ok && neuron_range.min_size >= 0;
+            neuron_range.max_size = values[1].toInt(&ok);
+            all_ok &= ok && neuron_range.max_size > neuron_range.min_size;
+            config.neuron_ranges.append(neuron_range);
+        }
+    }
+
+    config.sizes.clear();
+    foreach(QString size, parser.value(sizes_option).split(",", QString::SkipEmptyParts))
+    {
+        QStringList values = size.split("x");
+        all_ok &= values.size() == 2;
+        if(values.size() == 2)
+        {
+            qint32 width = values[0].toInt(&ok);
+            all_ok &= ok && width > 0;
+            qint32 height = values[1].toInt(&ok);
+            all_ok &= ok && height > 0;
+            config.sizes.append(QSize(width, height));
+        }
+    }
+    all_ok &= !config.sizes.isEmpty();
+
+    config.genomes = parser.value(genomes_option).toInt(&ok);
+    all_ok &= ok && config.genomes > 0;
+
+    QString network = parser.value(network_option);
+    config.cppn = network == "all" || network == "cppn";
+    config.direct_encoding = network == "all" || network == "direct";
+    config.animation = network == "all" || network == "animation";
+    all_ok &= config.cppn || config.direct_encoding || config.animation;
+    all_ok &= (!config.cppn && !config.animation) || !config.neuron_ranges.isEmpty();
+
+    if(!all_ok)
+    {
+        qCritical() << "Invalid arguments";
+        parser.showHelp(1);
+    }
+
+    CPPNKernelCompiler kernel_compiler;
+    config.kernel_compiler = parser.isSet(kernel_option) ? &kernel_compiler : NULL;
+
+    QFile file;
+    if(parser.isSet(output_option))
+    {
+        file.setFileName(parser.value(output_option));
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        {
+            qCritical() << "Can not open" << file.fileName();
+            return 1;
+        }
+    }
+    else
+    {
+        file.open(stdout, QIODevice::WriteOnly);
+    }
+    QTextStream stream(&file);
+
+    DifferentialHarness harness(config);
+    return harness.run(stream) ? 0 : 1;
+}